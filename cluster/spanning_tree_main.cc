@@ -25,25 +25,37 @@ using namespace VW;
 
 int main(int argc, char* argv[])
 {
-  if (argc > 2)
+  bool nondaemon = false;
+  const char* pid_file_name = nullptr;
+  int port = 26543;
+  for (int i = 1; i < argc; i++)
   {
-    std::cout << "usage: spanning_tree [--nondaemon | pid_file]" << std::endl;
-    exit(0);
+    if (strcmp("--nondaemon", argv[i]) == 0 && pid_file_name == nullptr)
+      nondaemon = true;
+    else if (strcmp("--port", argv[i]) == 0 && i + 1 < argc)
+      port = atoi(argv[++i]);
+    else if (argv[i][0] != '-' && !nondaemon && pid_file_name == nullptr)
+      pid_file_name = argv[i];
+    else
+    {
+      std::cout << "usage: spanning_tree [--nondaemon | pid_file] [--port port]" << std::endl;
+      exit(0);
+    }
   }
 
   try
   {
-    if (argc == 2 && strcmp("--nondaemon", argv[1]) == 0)
+    if (nondaemon)
       ;
     else if (daemon(1, 1))
       THROWERRNO("daemon: ");
 
-    SpanningTree spanningTree;
+    SpanningTree spanningTree((unsigned short)port);
 
-    if (argc == 2 && strcmp("--nondaemon", argv[1]) != 0)
+    if (pid_file_name != nullptr)
     {
       std::ofstream pid_file;
-      pid_file.open(argv[1]);
+      pid_file.open(pid_file_name);
       if (!pid_file.is_open())
       {
         std::cerr << "error writing pid file" << std::endl;
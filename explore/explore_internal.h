@@ -4,6 +4,7 @@
 
 // get the error code defined in master
 #include "explore.h"
+#include "explore_simd.h"
 
 #include <cstdint>
 #include <stdexcept>
@@ -34,6 +35,84 @@ namespace exploration
     return temp.f - 1;
   }
 
+  namespace detail
+  {
+    // Selects the SIMD kernels when both ranges are contiguous floats and SIMD is available.
+    template<typename... Its>
+    struct use_simd : std::false_type {};
+#ifdef EXPLORATION_HAVE_SIMD
+    template<typename It>
+    struct use_simd<It> : std::integral_constant<bool, float_stride<It>::value != 0> {};
+    template<typename InputIt, typename OutputIt>
+    struct use_simd<InputIt, OutputIt>
+        : std::integral_constant<bool, float_stride<InputIt>::value != 0 && float_stride<OutputIt>::value != 0> {};
+#endif
+
+    template<typename InputIt, typename OutputIt>
+    void softmax(float lambda, InputIt scores_first, InputIt scores_last, OutputIt pdf_first, OutputIt pdf_last, std::false_type /* use_simd */)
+    {
+      float norm = 0.;
+      float max_score = lambda > 0 ? *std::max_element(scores_first, scores_last)
+                                   : *std::min_element(scores_first, scores_last);
+
+      InputIt s = scores_first;
+      for (OutputIt d = pdf_first; d != pdf_last && s != scores_last; ++d, ++s)
+      {
+        float prob = std::exp(lambda*(*s - max_score));
+        norm += prob;
+
+        *d = prob;
+      }
+
+      // normalize
+      for (OutputIt d = pdf_first; d != pdf_last; ++d)
+        *d /= norm;
+    }
+
+    template<typename It>
+    void clamp_negative_to_zero(It pdf_first, It pdf_last, std::false_type /* use_simd */)
+    {
+      for (It pdf = pdf_first; pdf != pdf_last; ++pdf)
+        if (*pdf < 0)
+          *pdf = 0;
+    }
+
+    template<typename It>
+    void divide(It pdf_first, It pdf_last, float divisor, std::false_type /* use_simd */)
+    {
+      for (It pdf = pdf_first; pdf != pdf_last; ++pdf)
+        *pdf /= divisor;
+    }
+
+#ifdef EXPLORATION_HAVE_SIMD
+    template<typename InputIt, typename OutputIt>
+    void softmax(float lambda, InputIt scores_first, InputIt scores_last, OutputIt pdf_first, OutputIt pdf_last, std::true_type /* use_simd */)
+    {
+      // The kernel covers ranges of equal length, the scalar loop defines what happens otherwise.
+      const size_t num_scores = scores_last - scores_first;
+      const size_t num_pdf = pdf_last - pdf_first;
+      if (num_scores != num_pdf || num_pdf == 0)
+      {
+        softmax(lambda, scores_first, scores_last, pdf_first, pdf_last, std::false_type());
+        return;
+      }
+      simd::softmax<float_stride<InputIt>::value, float_stride<OutputIt>::value>(lambda, &*scores_first, &*pdf_first, num_pdf);
+    }
+
+    template<typename It>
+    void clamp_negative_to_zero(It pdf_first, It pdf_last, std::true_type /* use_simd */)
+    {
+      simd::clamp_negative_to_zero<float_stride<It>::value>(&*pdf_first, pdf_last - pdf_first);
+    }
+
+    template<typename It>
+    void divide(It pdf_first, It pdf_last, float divisor, std::true_type /* use_simd */)
+    {
+      simd::divide<float_stride<It>::value>(&*pdf_first, pdf_last - pdf_first, divisor);
+    }
+#endif
+  }
+
  template<typename It>
   int generate_epsilon_greedy(float epsilon, uint32_t top_action, It pdf_first, It pdf_last, std::random_access_iterator_tag /* pdf_tag */)
   {
@@ -89,22 +168,7 @@ namespace exploration
     if (pdf_last - pdf_first == 0)
       return E_EXPLORATION_BAD_RANGE;
 
-    float norm = 0.;
-    float max_score = lambda > 0 ? *std::max_element(scores_first, scores_last)
-                                 : *std::min_element(scores_first, scores_last);
-
-    InputIt s = scores_first;
-    for (OutputIt d = pdf_first; d != pdf_last && s != scores_last; ++d, ++s)
-    {
-      float prob = std::exp(lambda*(*s - max_score));
-      norm += prob;
-
-      *d = prob;
-    }
-
-    // normalize
-    for (OutputIt d = pdf_first; d != pdf_last; ++d)
-      *d /= norm;
+    detail::softmax(lambda, scores_first, scores_last, pdf_first, pdf_last, detail::use_simd<InputIt, OutputIt>());
 
     return S_EXPLORATION_OK;
   }
@@ -239,14 +303,12 @@ namespace exploration
       return E_EXPLORATION_BAD_RANGE;
     // Create a discrete_distribution based on the returned weights. This class handles the
     // case where the sum of the weights is < or > 1, by normalizing agains the sum.
+    detail::clamp_negative_to_zero(pdf_first, pdf_last, detail::use_simd<It>());
+
+    // The total is accumulated in order so the draw does not depend on the kernel used.
     float total = 0.f;
     for (It pdf = pdf_first; pdf != pdf_last; ++pdf)
-    {
-      if (*pdf < 0)
-        *pdf = 0;
-
       total += *pdf;
-    }
 
     // assume the first is the best
     if (total == 0)
@@ -266,17 +328,19 @@ namespace exploration
     for (It pdf = pdf_first; pdf != pdf_last; ++pdf, ++i)
     {
       sum += *pdf;
-      if (!index_found && sum > draw)
+      if (sum > draw)
       {
         chosen_index = i;
         index_found = true;
+        break;
       }
-      *pdf /= total;
     }
 
     if(!index_found)
       chosen_index = i - 1;
 
+    detail::divide(pdf_first, pdf_last, total, detail::use_simd<It>());
+
     return S_EXPLORATION_OK;
   }
 
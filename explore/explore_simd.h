@@ -0,0 +1,192 @@
+#pragma once
+
+// SSE2 kernels used by explore_internal.h when the scores and the pdf are float ranges with a fixed stride.
+// Define VW_NO_INLINE_SIMD to always use the scalar loops.
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#if !defined(VW_NO_INLINE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define EXPLORATION_HAVE_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace exploration
+{
+  namespace detail
+  {
+    // Distance in floats between the elements of an iterator the SIMD kernels can work on through a pointer to its
+    // first element, 0 if they cannot. 1 is contiguous floats. 2 is the scores of an array of records holding a
+    // 4 byte key followed by a float score, as {uint32_t action, float score}; an application declares such an
+    // iterator by specializing this template.
+    template<typename It>
+    struct float_stride : std::integral_constant<size_t, 0> {};
+    template<>
+    struct float_stride<float*> : std::integral_constant<size_t, 1> {};
+    template<>
+    struct float_stride<const float*> : std::integral_constant<size_t, 1> {};
+    template<>
+    struct float_stride<std::vector<float>::iterator> : std::integral_constant<size_t, 1> {};
+    template<>
+    struct float_stride<std::vector<float>::const_iterator> : std::integral_constant<size_t, 1> {};
+  }
+
+#ifdef EXPLORATION_HAVE_SIMD
+  namespace simd
+  {
+    // exp(x) for four floats, using the range reduction and polynomial of the Cephes expf.
+    // The result is within a few ulp of std::exp over the range where the float result is normal.
+    inline __m128 exp_ps(__m128 x)
+    {
+      const __m128 one = _mm_set1_ps(1.f);
+      x = _mm_min_ps(x, _mm_set1_ps(88.3762626647949f));
+      x = _mm_max_ps(x, _mm_set1_ps(-88.3762626647949f));
+
+      // n = round(x / ln(2))
+      __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f));
+      __m128 tmp = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+      // truncation rounds negative values up, step back to the floor
+      fx = _mm_sub_ps(tmp, _mm_and_ps(_mm_cmpgt_ps(tmp, fx), one));
+
+      // x - n * ln(2), with ln(2) split in two for precision
+      x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+      x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+
+      const __m128 z = _mm_mul_ps(x, x);
+      __m128 y = _mm_set1_ps(1.9875691500e-4f);
+      y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3f));
+      y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3f));
+      y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2f));
+      y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1f));
+      y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1f));
+      y = _mm_add_ps(_mm_mul_ps(y, z), _mm_add_ps(x, one));
+
+      // scale by 2^n
+      __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f));
+      n = _mm_slli_epi32(n, 23);
+      return _mm_mul_ps(y, _mm_castsi128_ps(n));
+    }
+
+    inline float horizontal_sum(__m128 v)
+    {
+      __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+      __m128 sums = _mm_add_ps(v, shuffled);
+      shuffled = _mm_movehl_ps(shuffled, sums);
+      return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+    }
+
+    inline float horizontal_max(__m128 v)
+    {
+      v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+      v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+      return _mm_cvtss_f32(v);
+    }
+
+    inline float horizontal_min(__m128 v)
+    {
+      v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+      v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+      return _mm_cvtss_f32(v);
+    }
+
+    // Four consecutive elements of a range with the given stride, p pointing at the first one.
+    template<size_t Stride>
+    inline __m128 load4(const float* p);
+    template<>
+    inline __m128 load4<1>(const float* p) { return _mm_loadu_ps(p); }
+    template<>
+    inline __m128 load4<2>(const float* p)
+    {
+      // two records per load, the scores are the odd lanes
+      return _mm_shuffle_ps(_mm_loadu_ps(p - 1), _mm_loadu_ps(p + 3), _MM_SHUFFLE(3, 1, 3, 1));
+    }
+
+    template<size_t Stride>
+    inline void store4(float* p, __m128 v);
+    template<>
+    inline void store4<1>(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+    template<>
+    inline void store4<2>(float* p, __m128 v)
+    {
+      // the keys are only moved around, never used in arithmetic
+      const __m128 keys = _mm_shuffle_ps(_mm_loadu_ps(p - 1), _mm_loadu_ps(p + 3), _MM_SHUFFLE(2, 0, 2, 0));
+      _mm_storeu_ps(p - 1, _mm_unpacklo_ps(keys, v));
+      _mm_storeu_ps(p + 3, _mm_unpackhi_ps(keys, v));
+    }
+
+    // Largest (use_max) or smallest score of a non empty range.
+    template<size_t Stride>
+    inline float extreme_score(const float* scores, size_t n, bool use_max)
+    {
+      size_t i = 0;
+      float result = scores[0];
+      if (n >= 4)
+      {
+        __m128 acc = load4<Stride>(scores);
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+          const __m128 v = load4<Stride>(scores + i * Stride);
+          acc = use_max ? _mm_max_ps(acc, v) : _mm_min_ps(acc, v);
+        }
+        result = use_max ? horizontal_max(acc) : horizontal_min(acc);
+      }
+      for (; i < n; ++i)
+      {
+        const float score = scores[i * Stride];
+        if (use_max ? score > result : score < result) result = score;
+      }
+      return result;
+    }
+
+    template<size_t Stride>
+    inline void divide(float* pdf, size_t n, float divisor)
+    {
+      const __m128 divisor4 = _mm_set1_ps(divisor);
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4) store4<Stride>(pdf + i * Stride, _mm_div_ps(load4<Stride>(pdf + i * Stride), divisor4));
+      for (; i < n; ++i) pdf[i * Stride] /= divisor;
+    }
+
+    // pdf[i] = exp(lambda * (scores[i] - max_score)) / norm
+    template<size_t ScoreStride, size_t PdfStride>
+    inline void softmax(float lambda, const float* scores, float* pdf, size_t n)
+    {
+      const float max_score = extreme_score<ScoreStride>(scores, n, lambda > 0);
+      const __m128 lambda4 = _mm_set1_ps(lambda);
+      const __m128 max4 = _mm_set1_ps(max_score);
+
+      __m128 norm4 = _mm_setzero_ps();
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+      {
+        const __m128 prob = exp_ps(_mm_mul_ps(lambda4, _mm_sub_ps(load4<ScoreStride>(scores + i * ScoreStride), max4)));
+        norm4 = _mm_add_ps(norm4, prob);
+        store4<PdfStride>(pdf + i * PdfStride, prob);
+      }
+      float norm = horizontal_sum(norm4);
+      for (; i < n; ++i)
+      {
+        const float prob = _mm_cvtss_f32(exp_ps(_mm_set_ss(lambda * (scores[i * ScoreStride] - max_score))));
+        norm += prob;
+        pdf[i * PdfStride] = prob;
+      }
+
+      divide<PdfStride>(pdf, n, norm);
+    }
+
+    // Replaces negative entries by zero, NaN entries are left as they are, like the scalar loop.
+    template<size_t Stride>
+    inline void clamp_negative_to_zero(float* pdf, size_t n)
+    {
+      const __m128 zero = _mm_setzero_ps();
+      size_t i = 0;
+      // maxps returns its second operand if either is NaN, so zero must come first
+      for (; i + 4 <= n; i += 4) store4<Stride>(pdf + i * Stride, _mm_max_ps(zero, load4<Stride>(pdf + i * Stride)));
+      for (; i < n; ++i)
+        if (pdf[i * Stride] < 0) pdf[i * Stride] = 0;
+    }
+  }
+#endif
+}
@@ -941,5 +941,6 @@ BOOST_PYTHON_MODULE(pylibvw)
   .def_readonly("AUTO_HAMMING_LOSS", Search::AUTO_HAMMING_LOSS, "Tell search to automatically compute hamming loss over predictions")
   .def_readonly("EXAMPLES_DONT_CHANGE", Search::EXAMPLES_DONT_CHANGE, "Tell search that on a single structured 'run', you don't change the examples you pass to predict")
   .def_readonly("IS_LDF", Search::IS_LDF, "Tell search that this is an LDF task")
+  .def_readonly("STATE_COMPLETE_CONDITIONING", Search::STATE_COMPLETE_CONDITIONING, "Tell search that the tag and conditioning of a prediction determine it across examples, so cached predictions can be kept for a whole pass")
   ;
 }
@@ -9,10 +9,14 @@ if __name__ == '__main__':
   parser.add_argument("--data_files", help="Data files to use, one per node", type=str, nargs='+', required=True)
   parser.add_argument("--test_file", help="Test input file to feed to final model", type=str, required=True)
   parser.add_argument("--vw_args", help="Extra vw arguments to to use", type=str, default="")
+  parser.add_argument("--node_args", help="Extra vw arguments for the cluster nodes only", type=str, default="")
+  parser.add_argument("--port", help="Port of the spanning tree", type=int, default=26543)
   parser.add_argument("--prediction_file", help="", type=str, default=None)
   args = parser.parse_args()
 
   spanning_tree_args = [args.spanning_tree, "--nondaemon"]
+  if args.port != 26543:
+    spanning_tree_args.extend(["--port", str(args.port)])
   print("Starting spanning_tree with args: " + " ".join(spanning_tree_args[1:]))
   spanning_tree_proc = subprocess.Popen(spanning_tree_args, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
 
@@ -21,6 +25,9 @@ if __name__ == '__main__':
   for index, data_file in enumerate(args.data_files):
     cmd_args = [args.vw, "--span_server", "localhost", "--total", str(len(args.data_files)), "--node", str(index), "--unique_id", "1234", "-d", data_file]
     cmd_args.extend(split_vw_args)
+    cmd_args.extend(args.node_args.split())
+    if args.port != 26543:
+      cmd_args.extend(["--span_server_port", str(args.port)])
     if(index == len(args.data_files) - 1):
       cmd_args.extend(["-f", "final.model"])
     print("Starting VW with args: " + " ".join(cmd_args[1:]))
@@ -0,0 +1,89 @@
+import os
+import sys
+import time
+import signal
+import socket
+import argparse
+import threading
+import subprocess
+
+def wait_for_port(port, proc, timeout=30):
+  deadline = time.time() + timeout
+  while time.time() < deadline:
+    if proc.poll() is not None:
+      return False
+    try:
+      socket.create_connection(("localhost", port), 1).close()
+      return True
+    except OSError:
+      time.sleep(0.1)
+  return False
+
+def stop_servers(procs):
+  # the forked children share the server's process group
+  for proc in procs:
+    os.killpg(proc.pid, signal.SIGKILL)
+    proc.wait()
+
+def hang_up_server(listener):
+  # reads the first bytes of a connection and closes it without answering
+  while True:
+    conn, _ = listener.accept()
+    conn.recv(1)
+    conn.close()
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser()
+  parser.add_argument("--vw", help="Path to VW binary to use", type=str, required=True)
+  parser.add_argument("--model", help="Model the prediction servers load", type=str, required=True)
+  parser.add_argument("--data_file", help="Examples to send", type=str, required=True)
+  parser.add_argument("--ports", help="Ports of the prediction servers, one server per port", type=int, nargs='+', required=True)
+  parser.add_argument("--hang_up_port", help="Port of a server that closes every connection unanswered", type=int, default=None)
+  parser.add_argument("--vw_args", help="Extra vw arguments for the sending vw", type=str, default="")
+  parser.add_argument("--prediction_file", help="", type=str, default=None)
+  args = parser.parse_args()
+
+  server_procs = []
+  for port in args.ports:
+    cmd_args = [args.vw, "-t", "-i", args.model, "--daemon", "--foreground", "--num_children", "1", "--port", str(port), "--quiet"]
+    print("Starting VW server with args: " + " ".join(cmd_args[1:]))
+    proc = subprocess.Popen(cmd_args, stdout=subprocess.PIPE, stderr=subprocess.PIPE, start_new_session=True)
+    server_procs.append(proc)
+    if not wait_for_port(port, proc):
+      print("VW server on port " + str(port) + " did not start")
+      stop_servers(server_procs)
+      sys.exit(1)
+
+  ports = list(args.ports)
+  if args.hang_up_port is not None:
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(("localhost", args.hang_up_port))
+    listener.listen(1)
+    threading.Thread(target=hang_up_server, args=(listener,), daemon=True).start()
+    ports.append(args.hang_up_port)
+
+  cmd_args = [args.vw, "-d", args.data_file]
+  for port in ports:
+    cmd_args.extend(["--sendto", "localhost:" + str(port)])
+  cmd_args.extend(args.vw_args.split())
+  if(args.prediction_file is not None):
+    cmd_args.extend(["-p", args.prediction_file])
+  print("Running VW with args: " + " ".join(cmd_args[1:]))
+  sys.stdout.flush()
+  if args.hang_up_port is None:
+    return_code = subprocess.Popen(cmd_args).wait()
+    stop_servers(server_procs)
+    if return_code != 0:
+      print("VW failed")
+      sys.exit(1)
+  else:
+    # how many examples were in flight when the hang up was noticed depends on timing, so only check the error
+    proc = subprocess.Popen(cmd_args, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    stderr = proc.communicate()[1].decode("utf-8")
+    stop_servers(server_procs)
+    if proc.returncode == 0 or ("--sendto localhost:" + str(args.hang_up_port) + " closed the connection") not in stderr:
+      print("VW did not report the closed connection:")
+      print("STDERR: \n" + stderr)
+      sys.exit(1)
+    print("VW reported the closed connection")
@@ -0,0 +1,63 @@
+import sys
+import time
+import socket
+import struct
+import argparse
+import subprocess
+
+# Brings up several concurrent cluster jobs against one spanning_tree to check that
+# registration scales with the number of nodes and that jobs do not block each other.
+# Clients that reset their connection right after registering are thrown in first, the
+# spanning_tree has to keep serving the real jobs after failing to answer them.
+
+def drop_client(port, nonce):
+  s = socket.create_connection(("localhost", port))
+  # close with a reset, so that acknowledging the registration fails
+  s.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+  s.sendall(struct.pack("=QQQ", nonce, 2, 0))
+  s.close()
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser()
+  parser.add_argument("--vw", help="Path to VW binary to use", type=str, required=True)
+  parser.add_argument("--spanning_tree", help="Path to spanning tree binary to use", type=str, required=True)
+  parser.add_argument("--port", help="Port of the spanning tree", type=int, default=26543)
+  parser.add_argument("--data_file", help="Data file every node trains on", type=str, required=True)
+  parser.add_argument("--nodes", help="Number of nodes per job", type=int, default=100)
+  parser.add_argument("--jobs", help="Number of concurrent jobs (distinct unique_ids)", type=int, default=4)
+  parser.add_argument("--drop_clients", help="Number of clients resetting their connection", type=int, default=0)
+  parser.add_argument("--timings", help="Print how long registration took", action="store_true")
+  args = parser.parse_args()
+
+  spanning_tree_args = [args.spanning_tree, "--nondaemon", "--port", str(args.port)]
+  print("Starting spanning_tree with args: " + " ".join(spanning_tree_args[1:]))
+  spanning_tree_proc = subprocess.Popen(spanning_tree_args, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+  time.sleep(0.5)
+
+  for i in range(args.drop_clients):
+    drop_client(args.port, 2000 + i)
+  if args.drop_clients:
+    print("Dropped {} clients".format(args.drop_clients))
+
+  start = time.time()
+  vw_procs = []
+  for job in range(args.jobs):
+    for node in range(args.nodes):
+      cmd_args = [args.vw, "--span_server", "localhost", "--span_server_port", str(args.port), "--total", str(args.nodes), "--node", str(node), "--unique_id", str(1000 + job), "-d", args.data_file, "--quiet"]
+      vw_procs.append(subprocess.Popen(cmd_args, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE))
+  print("Started {} VW processes in {} jobs".format(len(vw_procs), args.jobs))
+
+  failed = 0
+  for proc in vw_procs:
+    if proc.wait() != 0:
+      failed += 1
+      print("VW failed:\n" + proc.stderr.read().decode("utf-8"))
+  print("{} of {} VW processes succeeded".format(len(vw_procs) - failed, len(vw_procs)))
+  if args.timings:
+    print("All jobs finished in {:.2f}s".format(time.time() - start))
+
+  spanning_tree_proc.kill()
+  for line in spanning_tree_proc.stderr.read().decode("utf-8").splitlines():
+    if args.timings and "registered in" in line:
+      print(line)
+  sys.exit(1 if failed else 0)
@@ -0,0 +1,132 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#ifndef _WIN32
+
+#include <csignal>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "allreduce.h"
+
+namespace
+{
+void add_float(float& c1, const float& c2) { c1 += c2; }
+
+std::string segment_name(const char* test) { return std::string("/vw_shm_test_") + test + "_" + std::to_string(getpid()); }
+
+// Reduces a buffer spanning several slots as node of total and checks the result.
+bool reduce_and_check(const std::string& name, size_t total, size_t node, double timeout)
+{
+  AllReduceSharedMemory reducer(name, total, node, total, nullptr, true, timeout);
+  std::vector<float> buffer(shm_slot_size / sizeof(float) + 1000);
+  for (size_t i = 0; i < buffer.size(); i++) buffer[i] = (float)((node + 1) * (i % 100));
+  reducer.all_reduce<float, add_float>(buffer.data(), buffer.size());
+
+  const float scale = (float)(total * (total + 1) / 2);
+  for (size_t i = 0; i < buffer.size(); i++)
+    if (buffer[i] != scale * (float)(i % 100))
+      return false;
+  return true;
+}
+
+// Runs reduce_and_check on total processes, this one being node 0, and returns whether all of them succeeded.
+bool reduce_in_processes(const std::string& name, size_t total)
+{
+  std::vector<pid_t> children;
+  for (size_t node = 1; node < total; node++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      bool ok = false;
+      try
+      {
+        ok = reduce_and_check(name, total, node, 30.);
+      }
+      catch (...)
+      {
+      }
+      _exit(ok ? 0 : 1);
+    }
+    children.push_back(pid);
+  }
+
+  bool ok = reduce_and_check(name, total, 0, 30.);
+  for (pid_t pid : children)
+  {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  return ok;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(allreduce_shared_memory_reduces_across_processes)
+{
+  BOOST_CHECK(reduce_in_processes(segment_name("reduce"), 3));
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_shared_memory_replaces_stale_segment)
+{
+  // leave a segment as a crashed run would: set up, fully attached and with a process waiting in the barrier
+  const std::string name = segment_name("stale");
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+  BOOST_REQUIRE(fd >= 0);
+  const size_t size = 64 + 3 * shm_slot_size;
+  BOOST_REQUIRE(ftruncate(fd, (off_t)size) == 0);
+  void* segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  BOOST_REQUIRE(segment != MAP_FAILED);
+  // arrived, generation, ready, attached, started
+  const uint32_t stale[] = {1, 7, 0x56575348, 3, 1};
+  memcpy(segment, stale, sizeof(stale));
+  munmap(segment, size);
+
+  BOOST_CHECK(reduce_in_processes(name, 3));
+  shm_unlink(name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_shared_memory_notices_exited_process)
+{
+  // children are reaped automatically, so an exited one is gone rather than a zombie
+  auto previous = signal(SIGCHLD, SIG_IGN);
+  const std::string name = segment_name("exited");
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    try
+    {  // attach, then exit without reducing
+      AllReduceSharedMemory reducer(name, 2, 0, 2, nullptr, true, 30.);
+    }
+    catch (...)
+    {
+    }
+    _exit(0);
+  }
+
+  // no time limit, the exit of the other process is what ends the wait
+  BOOST_CHECK_THROW(reduce_and_check(name, 2, 1, 0.), VW::vw_exception);
+  signal(SIGCHLD, previous);
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_shared_memory_times_out)
+{
+  // nobody creates the segment
+  BOOST_CHECK_THROW(AllReduceSharedMemory(segment_name("timeout"), 2, 1, 2, nullptr, true, 0.2), VW::vw_exception);
+}
+
+#endif
@@ -1,17 +1,99 @@
-
-#ifndef STATIC_LINK_VW
-#define BOOST_TEST_DYN_LINK
-#endif
-
-#include <boost/test/unit_test.hpp>
-
-#include "vw.h"
-
-BOOST_AUTO_TEST_CASE(cb_explore_adf_should_throw_empty_multi_example) {
-  auto vw = VW::initialize("--cb_explore_adf --quiet", nullptr, false, nullptr, nullptr);
-  multi_ex example_collection;
-
-  // An empty example collection is invalid and so should throw.
-  BOOST_REQUIRE_THROW(vw->learn(example_collection), VW::vw_exception);
-  VW::finish(*vw);
-}
+
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "vw.h"
+
+BOOST_AUTO_TEST_CASE(cb_explore_adf_should_throw_empty_multi_example) {
+  auto vw = VW::initialize("--cb_explore_adf --quiet", nullptr, false, nullptr, nullptr);
+  multi_ex example_collection;
+
+  // An empty example collection is invalid and so should throw.
+  BOOST_REQUIRE_THROW(vw->learn(example_collection), VW::vw_exception);
+  VW::finish(*vw);
+}
+
+BOOST_AUTO_TEST_CASE(cb_explore_adf_top_k_returns_renormalized_sparse_pdf) {
+  auto vw = VW::initialize("--cb_explore_adf --epsilon 0.2 --cb_explore_top_k 2 --quiet", nullptr, false, nullptr, nullptr);
+  multi_ex examples;
+  examples.push_back(VW::read_example(*vw, std::string("shared | s_1")));
+  examples.push_back(VW::read_example(*vw, std::string("0:1.0:0.5 | a_1")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_2")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_3")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_4")));
+  vw->learn(examples);
+  vw->finish_example(examples);
+  examples.clear();
+
+  examples.push_back(VW::read_example(*vw, std::string("shared | s_1")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_1")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_2")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_3")));
+  examples.push_back(VW::read_example(*vw, std::string("| a_4")));
+  vw->predict(examples);
+
+  const auto& preds = examples[0]->pred.a_s;
+  BOOST_REQUIRE_EQUAL(preds.size(), 2);
+  BOOST_CHECK_GE(preds[0].score, preds[1].score);
+  BOOST_CHECK_CLOSE(preds[0].score + preds[1].score, 1.f, 1e-3f);
+  vw->finish_example(examples);
+  VW::finish(*vw);
+}
+
+namespace
+{
+// Learns from the same two decisions and returns the action scores predicted for a third one.
+std::vector<ACTION_SCORE::action_score> top_k_predictions(const std::string& args)
+{
+  auto vw = VW::initialize(args + " --quiet", nullptr, false, nullptr, nullptr);
+  const std::vector<std::vector<std::string>> decisions = {
+      {"shared | s_1", "0:1.0:0.5 | a_1", "| a_2", "| a_3 b", "| a_4", "| a_5"},
+      {"shared | s_2", "| a_1", "| a_2", "0:-1.0:0.5 | a_3 b", "| a_4", "| a_5"},
+      {"shared | s_1", "| a_1", "| a_2", "| a_3 b", "| a_4", "| a_5"}};
+
+  std::vector<ACTION_SCORE::action_score> result;
+  for (size_t d = 0; d < decisions.size(); d++)
+  {
+    multi_ex examples;
+    for (const auto& line : decisions[d]) examples.push_back(VW::read_example(*vw, line));
+    if (d + 1 < decisions.size())
+      vw->learn(examples);
+    else
+    {
+      vw->predict(examples);
+      result.assign(examples[0]->pred.a_s.begin(), examples[0]->pred.a_s.end());
+    }
+    vw->finish_example(examples);
+  }
+  VW::finish(*vw);
+  return result;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(cb_explore_adf_top_k_is_the_cut_full_ranking) {
+  // bag and cover select the top k while sorting, greedy and softmax cut an already ranked list and rnd has to select
+  for (const std::string args : {"--cb_explore_adf --bag 3 --epsilon 0.1", "--cb_explore_adf --cover 3",
+           "--cb_explore_adf --epsilon 0.2", "--cb_explore_adf --softmax --lambda 2",
+           "--cb_explore_adf --rnd 2 --epsilon 0.05"})
+  {
+    auto full = top_k_predictions(args);
+    std::stable_sort(full.begin(), full.end(),
+        [](const ACTION_SCORE::action_score& a, const ACTION_SCORE::action_score& b) { return a.score > b.score; });
+    const auto top = top_k_predictions(args + " --cb_explore_top_k 3");
+
+    BOOST_REQUIRE_EQUAL(top.size(), 3);
+    const float total = full[0].score + full[1].score + full[2].score;
+    for (size_t i = 0; i < top.size(); i++)
+    {
+      BOOST_CHECK_EQUAL(top[i].action, full[i].action);
+      BOOST_CHECK_CLOSE(top[i].score, full[i].score / total, 1e-3f);
+    }
+  }
+}
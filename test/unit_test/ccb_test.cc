@@ -116,3 +116,27 @@ BOOST_AUTO_TEST_CASE(ccb_exploration_reproducibility_test)
     VW::finish_example(*vw, examples);
   }
 }
+
+BOOST_AUTO_TEST_CASE(ccb_slot_namespaces_removed_from_shared)
+{
+  auto& vw = *VW::initialize("--ccb_explore_adf --quiet");
+  multi_ex examples;
+  examples.push_back(VW::read_example(vw, std::string("ccb shared |User f")));
+  examples.push_back(VW::read_example(vw, std::string("ccb action |Action f")));
+  examples.push_back(VW::read_example(vw, std::string("ccb action |Action g")));
+  examples.push_back(VW::read_example(vw, std::string("ccb slot |Slot a |Other b")));
+  examples.push_back(VW::read_example(vw, std::string("ccb slot |Slot c b")));
+
+  const std::vector<namespace_index> shared_indices(examples[0]->indices.begin(), examples[0]->indices.end());
+  vw.predict(examples);
+
+  // neither the slot namespaces nor the slot id are left behind in the shared example
+  const std::vector<namespace_index> indices_after(examples[0]->indices.begin(), examples[0]->indices.end());
+  check_collections_exact(indices_after, shared_indices);
+  BOOST_CHECK_EQUAL(examples[0]->feature_space['S'].size(), 0);
+  BOOST_CHECK_EQUAL(examples[0]->feature_space['O'].size(), 0);
+  BOOST_CHECK_EQUAL(examples[0]->feature_space[ccb_id_namespace].size(), 0);
+
+  vw.finish_example(examples);
+  VW::finish(vw);
+}
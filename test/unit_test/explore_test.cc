@@ -8,7 +8,10 @@
 #include "test_common.h"
 
 #include <vector>
+#include <deque>
+#include <cmath>
 #include "../../explore/explore.h"
+#include "action_score.h"
 
 BOOST_AUTO_TEST_CASE(sample_after_nomalizing_basic) {
   std::vector<float> pdf = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
@@ -61,3 +64,78 @@ BOOST_AUTO_TEST_CASE(swap_test) {
   const std::vector<float> expected_pdf_2 = { 0.266666667f,	0.133333333f,	0.2f,	0.066666667f,	0.333333333f };
   check_collections_with_float_tolerance(pdf, expected_pdf_2, .0001f);
 }
+
+// std::vector<float> goes through the SIMD kernels when they are available, std::deque<float> always uses the scalar
+// loops, so the two are compared against each other.
+BOOST_AUTO_TEST_CASE(softmax_contiguous_matches_scalar_reference) {
+  for (size_t num_actions : { 1, 3, 4, 7, 16, 33 })
+  {
+    for (float lambda : { -1.f, 0.5f, 3.f })
+    {
+      std::vector<float> scores;
+      for (size_t i = 0; i < num_actions; i++) scores.push_back(std::sin(1.7f * i) * 4.f);
+      std::deque<float> scores_ref(scores.begin(), scores.end());
+
+      std::vector<float> pdf(num_actions);
+      std::deque<float> pdf_ref(num_actions);
+      BOOST_CHECK_EQUAL(
+          S_EXPLORATION_OK, exploration::generate_softmax(lambda, begin(scores), end(scores), begin(pdf), end(pdf)));
+      BOOST_CHECK_EQUAL(S_EXPLORATION_OK,
+          exploration::generate_softmax(lambda, begin(scores_ref), end(scores_ref), begin(pdf_ref), end(pdf_ref)));
+      check_collections_with_float_tolerance(pdf, pdf_ref, 1e-3f);
+    }
+  }
+}
+
+// action_scores are read through score_iterator, which the SIMD kernels load with a stride of two floats.
+BOOST_AUTO_TEST_CASE(softmax_action_scores_matches_scalar_reference) {
+  for (size_t num_actions : { 1, 3, 4, 7, 16, 33 })
+  {
+    for (float lambda : { -1.f, 0.5f, 3.f })
+    {
+      std::vector<ACTION_SCORE::action_score> a_s;
+      for (size_t i = 0; i < num_actions; i++) a_s.push_back({(uint32_t)i, std::sin(1.7f * i) * 4.f});
+      std::deque<float> scores_ref;
+      for (auto& as : a_s) scores_ref.push_back(as.score);
+
+      std::vector<float> pdf(num_actions);
+      std::deque<float> pdf_ref(num_actions);
+      ACTION_SCORE::score_iterator scores_begin(a_s.data());
+      ACTION_SCORE::score_iterator scores_end(a_s.data() + a_s.size());
+      BOOST_CHECK_EQUAL(
+          S_EXPLORATION_OK, exploration::generate_softmax(lambda, scores_begin, scores_end, begin(pdf), end(pdf)));
+      BOOST_CHECK_EQUAL(S_EXPLORATION_OK,
+          exploration::generate_softmax(lambda, begin(scores_ref), end(scores_ref), begin(pdf_ref), end(pdf_ref)));
+      check_collections_with_float_tolerance(pdf, pdf_ref, 1e-3f);
+
+      // a pdf range shorter than the scores is only written within its own bounds
+      if (num_actions < 2) continue;
+      std::vector<float> short_pdf(num_actions / 2);
+      std::deque<float> short_pdf_ref(num_actions / 2);
+      BOOST_CHECK_EQUAL(S_EXPLORATION_OK,
+          exploration::generate_softmax(lambda, scores_begin, scores_end, begin(short_pdf), end(short_pdf)));
+      BOOST_CHECK_EQUAL(S_EXPLORATION_OK, exploration::generate_softmax(lambda, begin(scores_ref), end(scores_ref),
+                                              begin(short_pdf_ref), end(short_pdf_ref)));
+      check_collections_with_float_tolerance(short_pdf, short_pdf_ref, 1e-3f);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sample_after_normalizing_contiguous_matches_scalar_reference) {
+  std::vector<float> weights;
+  for (size_t i = 0; i < 37; i++) weights.push_back(std::cos(0.9f * i) * 2.f);
+
+  for (uint64_t seed = 1; seed < 200; seed++)
+  {
+    std::vector<float> pdf(weights);
+    std::deque<float> pdf_ref(weights.begin(), weights.end());
+    uint32_t chosen_index = 0;
+    uint32_t chosen_index_ref = 0;
+    BOOST_CHECK_EQUAL(
+        S_EXPLORATION_OK, exploration::sample_after_normalizing(seed * 7791, begin(pdf), end(pdf), chosen_index));
+    BOOST_CHECK_EQUAL(S_EXPLORATION_OK,
+        exploration::sample_after_normalizing(seed * 7791, begin(pdf_ref), end(pdf_ref), chosen_index_ref));
+    BOOST_CHECK_EQUAL(chosen_index, chosen_index_ref);
+    check_collections_exact(pdf, pdf_ref);
+  }
+}
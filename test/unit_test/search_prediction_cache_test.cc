@@ -0,0 +1,210 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "search_prediction_cache.h"
+#include "search_hooktask.h"
+#include "vw.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Search::prediction_cache;
+using Search::scored_action;
+
+namespace
+{
+// A key as the search serializes it: the first byte is the length of the whole key.
+std::vector<uint8_t> make_key(uint8_t id)
+{
+  std::vector<uint8_t> key(8, 0);
+  key[0] = (uint8_t)key.size();
+  key[1] = id;
+  return key;
+}
+
+bool cached(const prediction_cache& cache, uint8_t id, uint64_t hash)
+{
+  return cache.find(make_key(id).data(), hash) != nullptr;
+}
+
+void insert(prediction_cache& cache, uint8_t id, uint64_t hash, action a)
+{
+  cache.insert(make_key(id).data(), hash, scored_action(a, 0.5f * a));
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(search_prediction_cache_insert_and_lookup)
+{
+  prediction_cache cache;
+  cache.set_capacity(8);
+
+  BOOST_CHECK(cache.lookup(make_key(1).data(), 11) == nullptr);
+  insert(cache, 1, 11, 3);
+  insert(cache, 2, 12, 4);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+
+  const scored_action* found = cache.lookup(make_key(1).data(), 11);
+  BOOST_REQUIRE(found != nullptr);
+  BOOST_CHECK_EQUAL(found->a, 3);
+  BOOST_CHECK_CLOSE(found->s, 1.5f, 1e-5);
+
+  // the same hash with another key is a different entry
+  BOOST_CHECK(cache.lookup(make_key(2).data(), 11) == nullptr);
+
+  // the first prediction for a key is kept
+  insert(cache, 1, 11, 7);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.find(make_key(1).data(), 11)->a, 3);
+
+  // find does not count
+  BOOST_CHECK_EQUAL(cache.hits, 1);
+  BOOST_CHECK_EQUAL(cache.misses, 2);
+  BOOST_CHECK_EQUAL(cache.evictions, 0);
+}
+
+BOOST_AUTO_TEST_CASE(search_prediction_cache_grows_its_index)
+{
+  prediction_cache cache;
+  cache.set_capacity(200);
+  for (uint8_t id = 0; id < 200; id++) insert(cache, id, id * 2654435761u, id);
+  BOOST_CHECK_EQUAL(cache.size(), 200);
+  for (uint8_t id = 0; id < 200; id++)
+  {
+    const scored_action* found = cache.find(make_key(id).data(), id * 2654435761u);
+    BOOST_REQUIRE(found != nullptr);
+    BOOST_CHECK_EQUAL(found->a, id);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(search_prediction_cache_evicts_when_full)
+{
+  prediction_cache cache;
+  cache.set_capacity(16);
+  for (uint8_t id = 0; id < 200; id++) insert(cache, id, id * 2654435761u, id);
+
+  // without lookups every entry is as old as its insertion, so the last 16 remain
+  BOOST_CHECK_EQUAL(cache.size(), 16);
+  BOOST_CHECK_EQUAL(cache.evictions, 184);
+  for (uint8_t id = 0; id < 200; id++) BOOST_CHECK_EQUAL(cached(cache, id, id * 2654435761u), id >= 184);
+
+  // an entry that was looked up survives the next eviction
+  BOOST_REQUIRE(cache.lookup(make_key(184).data(), 184 * 2654435761u) != nullptr);
+  insert(cache, 200, 200 * 2654435761u, 200);
+  BOOST_CHECK(cached(cache, 184, 184 * 2654435761u));
+  BOOST_CHECK(!cached(cache, 185, 185 * 2654435761u));
+  BOOST_CHECK(cached(cache, 200, 200 * 2654435761u));
+  BOOST_CHECK_EQUAL(cache.size(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(search_prediction_cache_eviction_wraps_around_the_index)
+{
+  // The index has 64 slots. Hashes 62 and 63 take the last two slots, so the probe sequences of the second key with
+  // hash 63 and of the key with hash 0 continue at the start of the index.
+  prediction_cache cache;
+  cache.set_capacity(4);
+  insert(cache, 1, 62, 1);  // slot 62
+  insert(cache, 2, 63, 2);  // slot 63
+  insert(cache, 3, 63, 3);  // slot 0
+  insert(cache, 4, 0, 4);   // slot 1
+
+  // evicts key 1 from slot 62, the keys after it are in their probe sequences already
+  insert(cache, 5, 5, 5);
+  BOOST_CHECK(!cached(cache, 1, 62));
+  BOOST_CHECK(cached(cache, 2, 63));
+  BOOST_CHECK(cached(cache, 3, 63));
+  BOOST_CHECK(cached(cache, 4, 0));
+
+  // key 2 is protected, so key 3 is evicted from slot 0 and key 4 must move back into it
+  BOOST_REQUIRE(cache.lookup(make_key(2).data(), 63) != nullptr);
+  insert(cache, 6, 63, 6);
+  BOOST_CHECK(!cached(cache, 3, 63));
+  BOOST_CHECK(cached(cache, 2, 63));
+  BOOST_CHECK(cached(cache, 4, 0));
+  BOOST_CHECK(cached(cache, 5, 5));
+  BOOST_CHECK(cached(cache, 6, 63));
+  BOOST_CHECK_EQUAL(cache.find(make_key(6).data(), 63)->a, 6);
+  BOOST_CHECK_EQUAL(cache.evictions, 2);
+}
+
+BOOST_AUTO_TEST_CASE(search_prediction_cache_clear_invalidates_every_entry)
+{
+  prediction_cache cache;
+  cache.set_capacity(4);
+  for (int round = 0; round < 1000; round++)
+  {
+    for (uint8_t id = 0; id < 6; id++) insert(cache, id, id, (action)(round + id));
+    for (uint8_t id = 2; id < 6; id++)
+    {
+      const scored_action* found = cache.find(make_key(id).data(), id);
+      BOOST_REQUIRE(found != nullptr);
+      BOOST_CHECK_EQUAL(found->a, (action)(round + id));
+    }
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    for (uint8_t id = 0; id < 6; id++) BOOST_CHECK(!cached(cache, id, id));
+  }
+
+  // changing the capacity clears as well
+  insert(cache, 1, 1, 1);
+  cache.set_capacity(2);
+  BOOST_CHECK(!cached(cache, 1, 1));
+}
+
+namespace
+{
+example* hook_input = nullptr;
+
+// Two predictions on the same input, the second conditioned on the first.
+void predict_two_tags(Search::search& sch)
+{
+  Search::predictor P(sch, (ptag)1);
+  const action first = P.set_input(*hook_input).set_oracle(1).set_tag(1).predict();
+  P.reset();
+  const action second = P.set_input(*hook_input).set_oracle(2).set_tag(2).add_condition(1, 'p').predict();
+  sch.loss((first != 1 ? 1.f : 0.f) + (second != 2 ? 1.f : 0.f));
+}
+
+// Learns the same input a few times and returns the cache hits that the search reports at the end of the run.
+size_t search_cache_hits(bool state_complete)
+{
+  std::stringstream out, err;
+  std::streambuf* old_out = std::cout.rdbuf(out.rdbuf());
+  std::streambuf* old_err = std::cerr.rdbuf(err.rdbuf());
+
+  auto vw = VW::initialize("--search 3 --search_task hook --search_cache_size 100 --no_stdin");
+  Search::search& sch = *static_cast<Search::search*>(vw->searchstr);
+  if (state_complete)
+    sch.set_options(Search::STATE_COMPLETE_CONDITIONING);
+  sch.get_task_data<HookTask::task_data>()->run_f = predict_two_tags;
+
+  hook_input = VW::read_example(*vw, "1 | a b c");
+  multi_ex bogus = {VW::read_example(*vw, "1 | x")};
+  for (int i = 0; i < 5; i++) vw->learn(bogus);
+  vw->finish_example(bogus);
+  VW::finish_example(*vw, *hook_input);
+  VW::finish(*vw);
+
+  std::cout.rdbuf(old_out);
+  std::cerr.rdbuf(old_err);
+
+  const std::string report = "search cache hits = ";
+  const std::string output = err.str();
+  const size_t at = output.find(report);
+  BOOST_REQUIRE(at != std::string::npos);
+  return std::stoul(output.substr(at + report.size()));
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(search_prediction_cache_persists_with_state_complete_conditioning)
+{
+  // the cache is cleared for every example, and each example makes its two predictions once
+  BOOST_CHECK_EQUAL(search_cache_hits(false), 0);
+  // the four examples after the first find both of their predictions cached by the first one
+  BOOST_CHECK_EQUAL(search_cache_hits(true), 8);
+}
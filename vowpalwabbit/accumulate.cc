@@ -12,6 +12,7 @@ Alekh Agarwal and John Langford, with help Olivier Chapelle.
 #include <cstdint>
 #include "global_data.h"
 #include "vw_allreduce.h"
+#include "accumulate.h"
 
 void add_float(float& c1, const float& c2) { c1 += c2; }
 
@@ -145,3 +146,99 @@ void accumulate_weighted_avg(vw& all, parameters& weights)
         all, weights.dense_weights.first(), ((size_t)length) * (1ull << weights.stride_shift()));
   delete[] local_weights;
 }
+
+async_avg_state::~async_avg_state()
+{
+  if (worker.joinable())
+    worker.join();
+  // the reducer outlives the learners, and must not call back into this state once it is gone
+  if (reducer != nullptr)
+    reducer->join_background = nullptr;
+}
+
+template <class T>
+void snapshot_for_average(const T& weights, uint64_t length, bool adaptive, async_avg_state& state)
+{
+  const uint32_t stride_shift = weights.stride_shift();
+  for (uint64_t i = 0; i < length; i++)
+  {
+    const float* w = &weights[i << stride_shift];
+    state.snapshot[i] = w[0];
+    if (adaptive)
+    {  // weight each node's contribution by its adaptive accumulator, as accumulate_weighted_avg does
+      state.reduced[2 * i] = w[0] * w[1];
+      state.reduced[2 * i + 1] = w[1];
+    }
+    else
+      state.reduced[i] = w[0];
+  }
+}
+
+template <class T>
+void merge_average(T& weights, uint64_t length, bool adaptive, float numnodes, float mix, async_avg_state& state)
+{
+  const uint32_t stride_shift = weights.stride_shift();
+  for (uint64_t i = 0; i < length; i++)
+  {
+    float avg;
+    if (adaptive)
+      avg = state.reduced[2 * i + 1] > 0 ? state.reduced[2 * i] / state.reduced[2 * i + 1] : 0.f;
+    else
+      avg = state.reduced[i] / numnodes;
+    (&weights[i << stride_shift])[0] += mix * (avg - state.snapshot[i]);
+  }
+}
+
+void accumulate_avg_async_start(vw& all, parameters& weights, async_avg_state& state)
+{
+  if (state.pending)
+    THROW("a background weight average is already in progress");
+
+  uint64_t length = UINT64_ONE << all.num_bits;
+  state.snapshot.resize(length);
+  state.reduced.resize(weights.adaptive ? 2 * length : length);
+  if (weights.sparse)
+    snapshot_for_average(weights.sparse_weights, length, weights.adaptive, state);
+  else
+    snapshot_for_average(weights.dense_weights, length, weights.adaptive, state);
+
+  AllReduceType type = all.all_reduce_type;
+  AllReduce* reducer = all.all_reduce;
+  state.error = nullptr;
+  state.pending = true;
+  state.reducer = reducer;
+  state.worker = std::thread([type, reducer, &state]() {
+    try
+    {
+      all_reduce_unsynchronized<float, add_float>(type, reducer, state.reduced.data(), state.reduced.size());
+    }
+    catch (...)
+    {
+      state.error = std::current_exception();
+    }
+  });
+  reducer->join_background = [&state]() {
+    if (state.worker.joinable())
+      state.worker.join();
+  };
+}
+
+void accumulate_avg_async_finish(vw& all, parameters& weights, async_avg_state& state, float mix)
+{
+  if (!state.pending)
+    return;
+
+  all.all_reduce->join_background();
+  all.all_reduce->join_background = nullptr;
+  state.reducer = nullptr;
+  state.pending = false;
+  if (state.error)
+    std::rethrow_exception(state.error);
+
+  uint64_t length = UINT64_ONE << all.num_bits;
+  float numnodes = (float)all.all_reduce->total;
+  if (weights.sparse)
+    merge_average(weights.sparse_weights, length, weights.adaptive, numnodes, mix, state);
+  else
+    merge_average(weights.dense_weights, length, weights.adaptive, numnodes, mix, state);
+}
@@ -6,7 +6,30 @@
 #pragma once
 #include "global_data.h"
 
+#include <exception>
+#include <thread>
+#include <vector>
+
 void accumulate(vw& all, parameters& weights, size_t o);
 float accumulate_scalar(vw& all, float local_sum);
 void accumulate_weighted_avg(vw& all, parameters& weights);
 void accumulate_avg(vw& all, parameters& weights, size_t o);
+
+// State of an end-of-pass weight average that is reduced on a background thread while learning continues.
+struct async_avg_state
+{
+  std::thread worker;
+  std::vector<float> snapshot;  // local weights at the time the reduction was started
+  std::vector<float> reduced;   // reduced in place by the worker
+  std::exception_ptr error;
+  bool pending = false;
+  AllReduce* reducer = nullptr;  // its join_background refers to this state while set
+
+  ~async_avg_state();
+};
+
+// Snapshots the weights at offset 0 and starts averaging the snapshot across nodes in the background.
+void accumulate_avg_async_start(vw& all, parameters& weights, async_avg_state& state);
+// Waits for the background average and merges it into the weights as w += mix * (average - snapshot), so that
+// mix == 1 keeps the local progress made since the snapshot on top of the averaged model.
+void accumulate_avg_async_finish(vw& all, parameters& weights, async_avg_state& state, float mix);
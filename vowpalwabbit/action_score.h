@@ -5,8 +5,10 @@
 #pragma once
 
 #include "io/io_adapter.h"
+#include <cstddef>
 #include <iterator>
 #include "v_array.h"
+#include "explore_simd.h"
 
 namespace ACTION_SCORE
 {
@@ -83,3 +85,18 @@ void print_action_score(VW::io::writer* f, const v_array<action_score>& a_s, con
 
 void delete_action_scores(void* v);
 }  // namespace ACTION_SCORE
+
+namespace exploration
+{
+namespace detail
+{
+// The scores of an action_scores array are every other float, so the exploration SIMD kernels can run on it in place.
+template <>
+struct float_stride<ACTION_SCORE::score_iterator> : std::integral_constant<size_t, 2>
+{
+  static_assert(sizeof(ACTION_SCORE::action_score) == 2 * sizeof(float) &&
+          offsetof(ACTION_SCORE::action_score, score) == sizeof(float),
+      "action_score must be a 4 byte action followed by the float score");
+};
+}  // namespace detail
+}  // namespace exploration
@@ -7,6 +7,8 @@
 
 #include <string>
 #include <algorithm>
+#include <functional>
+#include <cstring>
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -82,6 +84,10 @@ class AllReduce
   const size_t node;   // node id number
   bool quiet;
 
+  // Set while a reduction is running on a background thread (see accumulate_avg_async_start). Blocking
+  // reductions call it first so that they never interleave with the background one on the same channel.
+  std::function<void()> join_background;
+
   AllReduce(size_t ptotal, const size_t pnode, bool pquiet = false) : total(ptotal), node(pnode), quiet(pquiet)
   {
     assert(node < total);
@@ -96,6 +102,30 @@ struct Data
   size_t length;
 };
 
+// The range [index, end) of a buffer of n elements that participant node of total reduces in a transposed allreduce.
+inline void reduction_block(const size_t n, const size_t total, const size_t node, size_t& index, size_t& end)
+{
+  size_t blockSize = n / total;
+
+  if (blockSize == 0)
+  {
+    if (node < n)
+    {
+      index = node;
+      end = node + 1;
+    }
+    else
+    {  // more participants than elements --> don't do any work
+      index = end = 0;
+    }
+  }
+  else
+  {
+    index = node * blockSize;
+    end = node == total - 1 ? n : (node + 1) * blockSize;
+  }
+}
+
 class AllReduceSync
 {
  private:
@@ -141,27 +171,9 @@ class AllReduceThreads : public AllReduce
     buffers[node] = buffer;
     m_sync->waitForSynchronization();
 
-    size_t blockSize = n / total;
     size_t index;
     size_t end;
-
-    if (blockSize == 0)
-    {
-      if (node < n)
-      {
-        index = node;
-        end = node + 1;
-      }
-      else
-      {  // more threads than bytes --> don't do any work
-        index = end = 0;
-      }
-    }
-    else
-    {
-      index = node * blockSize;
-      end = node == total - 1 ? n : (node + 1) * blockSize;
-    }
+    reduction_block(n, total, node, index, end);
 
     for (; index < end; index++)
     {  // Perform transposed AllReduce to help data locallity
@@ -305,3 +317,77 @@ class AllReduceSockets : public AllReduce
     broadcast((char*)buffer, n * sizeof(T));
   }
 };
+
+// Per-process staging area in the shared memory segment. Larger buffers are reduced in chunks of this size.
+constexpr size_t shm_slot_size = 1 << 20;
+
+struct shm_header;
+
+// Reduces across processes on one host through a POSIX shared memory segment. Every process stages its buffer in
+// its own slot and reduces a block of all slots, as AllReduceThreads does. If the nodes span several hosts, the
+// first process of each host additionally reduces the host's result over sockets with the other hosts.
+class AllReduceSharedMemory : public AllReduce
+{
+ private:
+  std::string m_name;
+  size_t m_local_total;
+  size_t m_local_node;
+  shm_header* m_header;
+  char* m_slots;
+  size_t m_segment_size;
+  AllReduceSockets* m_inter_host;  // set on the first process of each host if the nodes span several hosts
+  double m_timeout;                // seconds to wait for the other processes, 0 waits as long as they are alive
+
+  void create_segment();
+  void attach_segment();
+  void map_segment(int fd);
+  void unmap_segment();
+  void wait_for_peers();
+  char* slot(size_t i) { return m_slots + i * shm_slot_size; }
+
+ public:
+  // Nodes must be numbered host by host: node / local_total is the host, node % local_total the process on it.
+  AllReduceSharedMemory(const std::string& name, const size_t ptotal, const size_t pnode, const size_t local_total,
+      AllReduceSockets* inter_host, bool pquiet, double timeout = 0.);
+
+  virtual ~AllReduceSharedMemory();
+
+  template <class T, void (*f)(T&, const T&)>
+  void all_reduce(T* buffer, const size_t n)
+  {
+    const size_t chunk = shm_slot_size / sizeof(T);
+    for (size_t start = 0; start < n; start += chunk)
+    {
+      const size_t count = std::min(chunk, n - start);
+      memcpy(slot(m_local_node), buffer + start, count * sizeof(T));
+      wait_for_peers();
+
+      size_t index;
+      size_t end;
+      reduction_block(count, m_local_total, m_local_node, index, end);
+      for (; index < end; index++)
+      {  // Perform transposed AllReduce to help data locallity
+        T& first = ((T*)slot(0))[index];
+        for (size_t i = 1; i < m_local_total; i++) f(first, ((T*)slot(i))[index]);
+
+        if (total == m_local_total)
+          // Broadcast back
+          for (size_t i = 1; i < m_local_total; i++) ((T*)slot(i))[index] = first;
+      }
+      wait_for_peers();
+
+      if (total == m_local_total)
+      {  // only this process touches its own slot until the next chunk is staged
+        memcpy(buffer + start, slot(m_local_node), count * sizeof(T));
+        continue;
+      }
+
+      if (m_local_node == 0)
+        m_inter_host->all_reduce<T, f>((T*)slot(0), count);
+      wait_for_peers();
+      memcpy(buffer + start, slot(0), count * sizeof(T));
+      // slot 0 is staged again by the next chunk
+      wait_for_peers();
+    }
+  }
+};
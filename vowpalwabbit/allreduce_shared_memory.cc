@@ -0,0 +1,301 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+/*
+This implements the allreduce function over POSIX shared memory for processes on the same host.
+*/
+#include "allreduce.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Lives at the start of the segment, followed by the pid of each process. The creator opens the segment with
+// O_EXCL, so it is zero filled, which is a valid initial state, until it sets ready.
+struct shm_header
+{
+  std::atomic<uint32_t> arrived;
+  std::atomic<uint32_t> generation;
+  std::atomic<uint32_t> ready;     // shm_ready once process 0 set up the segment
+  std::atomic<uint32_t> attached;  // processes that mapped the segment, process 0 included
+  std::atomic<uint32_t> started;   // set by process 0 once all processes attached
+};
+
+#ifdef _WIN32
+
+AllReduceSharedMemory::AllReduceSharedMemory(const std::string& name, const size_t ptotal, const size_t pnode,
+    const size_t local_total, AllReduceSockets* inter_host, bool pquiet, double timeout)
+    : AllReduce(ptotal, pnode, pquiet)
+    , m_name(name)
+    , m_local_total(local_total)
+    , m_local_node(local_total == 0 ? 0 : pnode % local_total)
+    , m_header(nullptr)
+    , m_slots(nullptr)
+    , m_segment_size(0)
+    , m_inter_host(inter_host)
+    , m_timeout(timeout)
+{
+  THROW("shared memory allreduce is not supported on Windows");
+}
+
+AllReduceSharedMemory::~AllReduceSharedMemory() { delete m_inter_host; }
+
+void AllReduceSharedMemory::create_segment() {}
+void AllReduceSharedMemory::attach_segment() {}
+void AllReduceSharedMemory::map_segment(int) {}
+void AllReduceSharedMemory::unmap_segment() {}
+void AllReduceSharedMemory::wait_for_peers() {}
+
+#else
+
+namespace
+{
+constexpr uint32_t shm_ready = 0x56575348;  // "VWSH"
+
+// The header and the pids, padded to a cache line so that the slots start aligned.
+size_t header_size(size_t local_total)
+{
+  const size_t size = sizeof(shm_header) + local_total * sizeof(std::atomic<int32_t>);
+  return (size + 63) / 64 * 64;
+}
+
+std::atomic<int32_t>* pids(shm_header* header) { return reinterpret_cast<std::atomic<int32_t>*>(header + 1); }
+
+// Waits until done() holds. Throws if it takes longer than timeout seconds (0 for no limit) or if one of the other
+// processes exited, which would otherwise leave this one waiting forever.
+template <typename Done>
+void wait_until(shm_header* header, size_t local_total, size_t local_node, double timeout, const char* what, Done done)
+{
+  using clock = std::chrono::steady_clock;
+  const clock::time_point start = clock::now();
+  clock::time_point next_liveness_check = start + std::chrono::seconds(1);
+  for (size_t spins = 0; !done(); spins++)
+  {
+    // reductions are short compared to a context switch, so spin before sleeping
+    if (spins < 1024)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    const clock::time_point now = clock::now();
+    if (timeout > 0 && std::chrono::duration<double>(now - start).count() > timeout)
+      THROW("shared memory allreduce: timed out after " << timeout << " seconds waiting for " << what);
+    if (header != nullptr && now >= next_liveness_check)
+    {
+      for (size_t i = 0; i < local_total; i++)
+      {
+        const int32_t pid = pids(header)[i].load(std::memory_order_relaxed);
+        if (i != local_node && pid != 0 && kill(pid, 0) != 0 && errno == ESRCH)
+          THROW("shared memory allreduce: process " << i << " exited while waiting for " << what);
+      }
+      next_liveness_check = now + std::chrono::seconds(1);
+    }
+  }
+}
+
+// True if name still refers to the segment with inode ino.
+bool same_segment(const std::string& name, ino_t ino)
+{
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  const bool same = fstat(fd, &st) == 0 && st.st_ino == ino;
+  close(fd);
+  return same;
+}
+}  // namespace
+
+AllReduceSharedMemory::AllReduceSharedMemory(const std::string& name, const size_t ptotal, const size_t pnode,
+    const size_t local_total, AllReduceSockets* inter_host, bool pquiet, double timeout)
+    : AllReduce(ptotal, pnode, pquiet)
+    , m_name(name)
+    , m_local_total(local_total)
+    , m_local_node(local_total == 0 ? 0 : pnode % local_total)
+    , m_header(nullptr)
+    , m_slots(nullptr)
+    , m_segment_size(0)
+    , m_inter_host(inter_host)
+    , m_timeout(timeout)
+{
+  try
+  {
+    if (local_total == 0 || ptotal % local_total != 0)
+      THROW("the number of nodes (" << ptotal << ") must be a multiple of the nodes per host (" << local_total << ")");
+    if (m_local_node == 0 && inter_host == nullptr && local_total != ptotal)
+      THROW("nodes on more than one host need a span server to reduce between hosts");
+
+    m_segment_size = header_size(local_total) + local_total * shm_slot_size;
+    if (m_local_node == 0)
+      create_segment();
+    else
+      attach_segment();
+  }
+  catch (...)
+  {
+    delete m_inter_host;
+    throw;
+  }
+
+  if (!quiet)
+    std::cerr << "shared memory allreduce " << m_name << ": process " << m_local_node << " of " << m_local_total
+              << std::endl;
+}
+
+AllReduceSharedMemory::~AllReduceSharedMemory()
+{
+  // process 0 removed the name as soon as every process attached, so there is nothing to wait for here
+  unmap_segment();
+  delete m_inter_host;
+}
+
+void AllReduceSharedMemory::map_segment(int fd)
+{
+  void* segment = mmap(nullptr, m_segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (segment == MAP_FAILED)
+    THROWERRNO("mmap(" << m_name << ")");
+  m_header = (shm_header*)segment;
+  m_slots = (char*)segment + header_size(m_local_total);
+}
+
+void AllReduceSharedMemory::unmap_segment()
+{
+  if (m_header != nullptr)
+    munmap(m_header, m_segment_size);
+  m_header = nullptr;
+  m_slots = nullptr;
+}
+
+void AllReduceSharedMemory::create_segment()
+{
+  // A segment left under this name by a crashed run holds a stale barrier. Replace it: processes that attached to
+  // it notice that the name moved and attach again.
+  shm_unlink(m_name.c_str());
+  int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+    THROWERRNO("shm_open(" << m_name << ")");
+  if (ftruncate(fd, (off_t)m_segment_size) < 0)
+  {
+    close(fd);
+    shm_unlink(m_name.c_str());
+    THROWERRNO("ftruncate(" << m_name << ")");
+  }
+  map_segment(fd);
+
+  try
+  {
+    pids(m_header)[0].store((int32_t)getpid(), std::memory_order_relaxed);
+    m_header->attached.store(1, std::memory_order_relaxed);
+    m_header->ready.store(shm_ready, std::memory_order_release);
+    wait_until(m_header, m_local_total, m_local_node, m_timeout, "the other processes to attach",
+        [this] { return m_header->attached.load(std::memory_order_acquire) >= m_local_total; });
+  }
+  catch (...)
+  {
+    shm_unlink(m_name.c_str());
+    unmap_segment();
+    throw;
+  }
+  m_header->started.store(1, std::memory_order_seq_cst);
+  // every process mapped the segment, so the name is not needed any more and a crash cannot leave it behind
+  shm_unlink(m_name.c_str());
+}
+
+void AllReduceSharedMemory::attach_segment()
+{
+  using clock = std::chrono::steady_clock;
+  const clock::time_point start = clock::now();
+  auto check_timeout = [&] {
+    if (m_timeout > 0 && std::chrono::duration<double>(clock::now() - start).count() > m_timeout)
+      THROW("shared memory allreduce: timed out after " << m_timeout << " seconds waiting for process 0 to create "
+                                                        << m_name);
+  };
+
+  for (;; std::this_thread::sleep_for(std::chrono::milliseconds(1)))
+  {
+    check_timeout();
+    int fd = shm_open(m_name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+      continue;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < m_segment_size)
+    {  // process 0 has not sized it yet
+      close(fd);
+      continue;
+    }
+    const ino_t ino = st.st_ino;
+    map_segment(fd);
+
+    bool joined = false;
+    try
+    {
+      // Until process 0 starts the run, the segment may be one left by a crashed run. Such a segment is replaced
+      // under the same name, or already has all its processes attached.
+      while (m_header->ready.load(std::memory_order_acquire) != shm_ready && same_segment(m_name, ino))
+      {
+        check_timeout();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (m_header->ready.load(std::memory_order_acquire) == shm_ready &&
+          m_header->attached.fetch_add(1, std::memory_order_acq_rel) < m_local_total)
+      {
+        pids(m_header)[m_local_node].store((int32_t)getpid(), std::memory_order_relaxed);
+        for (;;)
+        {
+          if (m_header->started.load(std::memory_order_seq_cst) != 0)
+          {
+            joined = true;
+            break;
+          }
+          // process 0 sets started before removing the name, so check it once more
+          if (!same_segment(m_name, ino))
+          {
+            joined = m_header->started.load(std::memory_order_seq_cst) != 0;
+            break;
+          }
+          check_timeout();
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+    }
+    catch (...)
+    {
+      unmap_segment();
+      throw;
+    }
+    if (joined)
+      return;
+    unmap_segment();
+  }
+}
+
+void AllReduceSharedMemory::wait_for_peers()
+{
+  // Sense reversing barrier: the last process to arrive resets the count and releases the others by advancing the
+  // generation.
+  uint32_t generation = m_header->generation.load(std::memory_order_acquire);
+  if (m_header->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_local_total)
+  {
+    m_header->arrived.store(0, std::memory_order_relaxed);
+    m_header->generation.fetch_add(1, std::memory_order_release);
+  }
+  else
+    wait_until(m_header, m_local_total, m_local_node, m_timeout, "the other processes to reach the reduction",
+        [this, generation] { return m_header->generation.load(std::memory_order_acquire) != generation; });
+}
+
+#endif
@@ -45,7 +45,8 @@ socket_t AllReduceSockets::sock_connect(const uint32_t ip, const int port)
   far_end.sin_addr = *(in_addr*)&ip;
   memset(&far_end.sin_zero, '\0', 8);
 
-  {
+  if (!quiet)
+  {  // the reverse lookup is only needed for the log message
     char dotted_quad[INET_ADDRSTRLEN];
     if (nullptr == inet_ntop(AF_INET, &(far_end.sin_addr), dotted_quad, INET_ADDRSTRLEN))
       THROWERRNO("inet_ntop");
@@ -55,8 +56,7 @@ socket_t AllReduceSockets::sock_connect(const uint32_t ip, const int port)
     if (getnameinfo((sockaddr*)&far_end, sizeof(sockaddr), hostname, NI_MAXHOST, servInfo, NI_MAXSERV, NI_NUMERICSERV))
       THROWERRNO("getnameinfo(" << dotted_quad << ")");
 
-    if (!quiet)
-      cerr << "connecting to " << dotted_quad << " = " << hostname << ':' << ntohs(port) << endl;
+    cerr << "connecting to " << dotted_quad << " = " << hostname << ':' << ntohs(port) << endl;
   }
 
   size_t count = 0;
@@ -118,14 +118,19 @@ void AllReduceSockets::all_reduce_init()
     THROWERRNO("WSAStartup() returned error:" << lastError);
 #endif
 
-  struct hostent* master = gethostbyname(span_server.c_str());
-
-  if (master == nullptr)
-    THROWERRNO("gethostbyname(" << span_server << ")");
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* master = nullptr;
+  int lookup = getaddrinfo(span_server.c_str(), nullptr, &hints, &master);
+  if (lookup != 0 || master == nullptr)
+    THROW("getaddrinfo(" << span_server << "): " << gai_strerror(lookup));
 
   socks.current_master = span_server;
 
-  uint32_t master_ip = *((uint32_t*)master->h_addr);
+  uint32_t master_ip = ((sockaddr_in*)master->ai_addr)->sin_addr.s_addr;
+  freeaddrinfo(master);
 
   socket_t master_sock = sock_connect(master_ip, htons(port));
   if (send(master_sock, (const char*)&unique_id, sizeof(unique_id), 0) < (int)sizeof(unique_id))
@@ -22,6 +22,14 @@ Implementation by Miro Dudik.
 #include "vw_exception.h"
 #include <exception>
 #include <chrono>
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
 
 using namespace VW::LEARNER;
 using namespace VW::config;
@@ -59,11 +67,85 @@ class curv_exception : public std::exception
 
 constexpr float max_precond_ratio = 10000.f;
 
+// Threads for the sweeps over the weights. They are started once in setup and wait between sweeps, so a pass does
+// not create and join threads for each of its vector operations.
+class sweep_workers
+{
+ public:
+  explicit sweep_workers(size_t count)
+  {
+    for (size_t k = 1; k < count; k++) _threads.emplace_back(&sweep_workers::work, this, k);
+  }
+
+  ~sweep_workers()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _start.notify_all();
+    for (auto& t : _threads) t.join();
+  }
+
+  size_t size() const { return _threads.size() + 1; }
+
+  // Calls job(k) for every k below size(), k = 0 on the calling thread, and returns once all calls are done.
+  void run(const std::function<void(size_t)>& job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _job = &job;
+      _pending = _threads.size();
+      _generation++;
+    }
+    _start.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _pending == 0; });
+    _job = nullptr;
+  }
+
+ private:
+  void work(size_t k)
+  {
+    uint64_t seen = 0;
+    while (true)
+    {
+      const std::function<void(size_t)>* job;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _start.wait(lock, [this, seen] { return _stop || _generation != seen; });
+        if (_stop)
+          return;
+        seen = _generation;
+        job = _job;
+      }
+      (*job)(k);
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending--;
+      }
+      _done.notify_one();
+    }
+  }
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _start;
+  std::condition_variable _done;
+  const std::function<void(size_t)>* _job = nullptr;
+  uint64_t _generation = 0;
+  size_t _pending = 0;
+  bool _stop = false;
+};
+
 struct bfgs
 {
   vw* all;  // prediction, regressor
   int m;
   float rel_threshold;  // termination threshold
+  size_t threads;       // workers for the sweeps over the weights
+  std::unique_ptr<sweep_workers> workers;
 
   double wolfe1_bound;
 
@@ -182,129 +264,164 @@ float dot_with_direction(vw& all, example& ec)
   return temp;
 }
 
-template <class T>
-double regularizer_direction_magnitude(vw& /* all */, bfgs& b, double regularizer, T& weights)
-{
-  double ret = 0.;
-  if (b.regularizers == nullptr)
-    for (typename T::iterator iter = weights.begin(); iter != weights.end(); ++iter)
-      ret += regularizer * (&(*iter))[W_DIR] * (&(*iter))[W_DIR];
+// Partial sums of a sweep over the weight rows. Every worker accumulates its own, and they are added in worker
+// order, so results only depend on the number of threads.
+using sweep_sums = std::array<double, 4>;
 
+// Calls body(row weights, row index, sums) for every weight row. Dense weights are split into contiguous blocks
+// of rows, one per worker.
+template <class F>
+std::vector<sweep_sums> sweep(bfgs& b, dense_parameters& weights, F body)
+{
+  const uint32_t stride_shift = weights.stride_shift();
+  const uint64_t rows = (weights.mask() + 1) >> stride_shift;
+  const size_t workers = b.workers ? b.workers->size() : 1;
+  std::vector<sweep_sums> partials(workers);
+
+  auto run = [&](size_t k) {
+    sweep_sums& sums = partials[k];
+    sums.fill(0.);
+    const uint64_t end = rows * (k + 1) / workers;
+    for (uint64_t i = rows * k / workers; i < end; i++) body(&weights[i << stride_shift], i, sums);
+  };
+
+  if (b.workers)
+    b.workers->run(run);
   else
-  {
-    for (typename T::iterator iter = weights.begin(); iter != weights.end(); ++iter)
-      ret += ((double)b.regularizers[2 * (iter.index() >> weights.stride_shift())]) * (&(*iter))[W_DIR] *
-          (&(*iter))[W_DIR];
-  }
+    run(0);
+  return partials;
+}
+
+template <class F>
+std::vector<sweep_sums> sweep(bfgs&, sparse_parameters& weights, F body)
+{
+  std::vector<sweep_sums> partials(1);
+  partials[0].fill(0.);
+  for (sparse_parameters::iterator w = weights.begin(); w != weights.end(); ++w)
+    body(&(*w), w.index() >> weights.stride_shift(), partials[0]);
+  return partials;
+}
+
+inline sweep_sums total(const std::vector<sweep_sums>& partials)
+{
+  sweep_sums ret = partials[0];
+  for (size_t k = 1; k < partials.size(); k++)
+    for (size_t j = 0; j < ret.size(); j++) ret[j] += partials[k][j];
   return ret;
 }
 
-double regularizer_direction_magnitude(vw& all, bfgs& b, float regularizer)
+template <class T>
+float direction_magnitude(vw& /* all */, bfgs& b, T& weights)
 {
   // compute direction magnitude
-  double ret = 0.;
-
-  if (regularizer == 0.)
-    return ret;
+  return (float)total(sweep(b, weights, [](float* w, uint64_t, sweep_sums& s) {
+    s[0] += ((double)w[W_DIR]) * w[W_DIR];
+  }))[0];
+}
 
+float direction_magnitude(vw& all, bfgs& b)
+{
+  // compute direction magnitude
   if (all.weights.sparse)
-    return regularizer_direction_magnitude(all, b, regularizer, all.weights.sparse_weights);
+    return direction_magnitude(all, b, all.weights.sparse_weights);
   else
-    return regularizer_direction_magnitude(all, b, regularizer, all.weights.dense_weights);
+    return direction_magnitude(all, b, all.weights.dense_weights);
 }
 
+// The three quantities needed after a curvature pass, computed in one sweep: the regularizer's contribution to the
+// curvature along the direction, the derivative in the direction and the direction magnitude.
 template <class T>
-float direction_magnitude(vw& /* all */, T& weights)
+sweep_sums curvature_pass_sums(vw& /* all */, bfgs& b, float* mem, int origin, double regularizer, T& weights)
 {
-  // compute direction magnitude
-  double ret = 0.;
-  for (typename T::iterator iter = weights.begin(); iter != weights.end(); ++iter)
-    ret += ((double)(&(*iter))[W_DIR]) * (&(*iter))[W_DIR];
-
-  return (float)ret;
+  const int mem_stride = b.mem_stride;
+  const weight* regularizers = b.regularizers;
+  return total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    float* mem1 = mem + i * mem_stride;
+    if (regularizer != 0.)
+      s[0] += (regularizers == nullptr ? regularizer : (double)regularizers[2 * i]) * w[W_DIR] * w[W_DIR];
+    s[1] += ((double)mem1[(MEM_GT + origin) % mem_stride]) * w[W_DIR];
+    s[2] += ((double)w[W_DIR]) * w[W_DIR];
+  }));
 }
 
-float direction_magnitude(vw& all)
+sweep_sums curvature_pass_sums(vw& all, bfgs& b, float* mem, int origin, float regularizer)
 {
-  // compute direction magnitude
   if (all.weights.sparse)
-    return direction_magnitude(all, all.weights.sparse_weights);
+    return curvature_pass_sums(all, b, mem, origin, regularizer, all.weights.sparse_weights);
   else
-    return direction_magnitude(all, all.weights.dense_weights);
+    return curvature_pass_sums(all, b, mem, origin, regularizer, all.weights.dense_weights);
 }
 
+// Returns the magnitude of the new direction.
 template <class T>
-void bfgs_iter_start(vw& all, bfgs& b, float* mem, int& lastj, double importance_weight_sum, int& origin, T& weights)
+float bfgs_iter_start(vw& all, bfgs& b, float* mem, int& lastj, double importance_weight_sum, int& origin, T& weights)
 {
-  double g1_Hg1 = 0.;
-  double g1_g1 = 0.;
-
   origin = 0;
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    if (b.m > 0)
-      mem1[(MEM_XT + origin) % b.mem_stride] = (&(*w))[W_XT];
-    mem1[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
-    g1_Hg1 += ((double)(&(*w))[W_GT]) * ((&(*w))[W_GT]) * ((&(*w))[W_COND]);
-    g1_g1 += ((double)((&(*w))[W_GT])) * ((&(*w))[W_GT]);
-    (&(*w))[W_DIR] = -(&(*w))[W_COND] * ((&(*w))[W_GT]);
-    ((&(*w))[W_GT]) = 0;
-  }
+  const int mem_stride = b.mem_stride;
+  const bool remember_xt = b.m > 0;
+  sweep_sums sums = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    float* mem1 = mem + i * mem_stride;
+    if (remember_xt)
+      mem1[(MEM_XT + origin) % mem_stride] = w[W_XT];
+    mem1[(MEM_GT + origin) % mem_stride] = w[W_GT];
+    s[0] += ((double)w[W_GT]) * (w[W_GT]) * (w[W_COND]);
+    s[1] += ((double)(w[W_GT])) * (w[W_GT]);
+    w[W_DIR] = -w[W_COND] * (w[W_GT]);
+    (w[W_GT]) = 0;
+    s[2] += ((double)w[W_DIR]) * w[W_DIR];
+  }));
+  double g1_Hg1 = sums[0];
+  double g1_g1 = sums[1];
+
   lastj = 0;
   if (!all.logger.quiet)
     fprintf(stderr, "%-10.5f\t%-10.5f\t%-10s\t%-10s\t%-10s\t", g1_g1 / (importance_weight_sum * importance_weight_sum),
         g1_Hg1 / importance_weight_sum, "", "", "");
+  return (float)sums[2];
 }
 
-void bfgs_iter_start(vw& all, bfgs& b, float* mem, int& lastj, double importance_weight_sum, int& origin)
+float bfgs_iter_start(vw& all, bfgs& b, float* mem, int& lastj, double importance_weight_sum, int& origin)
 {
   if (all.weights.sparse)
-    bfgs_iter_start(all, b, mem, lastj, importance_weight_sum, origin, all.weights.sparse_weights);
+    return bfgs_iter_start(all, b, mem, lastj, importance_weight_sum, origin, all.weights.sparse_weights);
   else
-    bfgs_iter_start(all, b, mem, lastj, importance_weight_sum, origin, all.weights.dense_weights);
+    return bfgs_iter_start(all, b, mem, lastj, importance_weight_sum, origin, all.weights.dense_weights);
 }
 
+// Returns the magnitude of the new direction.
 template <class T>
-void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha, int& lastj, int& origin, T& weights)
+float bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha, int& lastj, int& origin, T& weights)
 {
-  float* mem0 = mem;
-  uint32_t length = 1 << all.num_bits;
+  const int mem_stride = b.mem_stride;
   // implement conjugate gradient
   if (b.m == 0)
   {
-    double g_Hy = 0.;
-    double g_Hg = 0.;
-    double y = 0.;
-
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      y = (&(*w))[W_GT] - mem[(MEM_GT + origin) % b.mem_stride];
-      g_Hy += ((double)(&(*w))[W_GT]) * ((&(*w))[W_COND]) * y;
-      g_Hg +=
-          ((double)mem[(MEM_GT + origin) % b.mem_stride]) * ((&(*w))[W_COND]) * mem[(MEM_GT + origin) % b.mem_stride];
-    }
+    sweep_sums sums = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+      float* mem1 = mem + i * mem_stride;
+      double y = w[W_GT] - mem1[(MEM_GT + origin) % mem_stride];
+      s[0] += ((double)w[W_GT]) * (w[W_COND]) * y;
+      s[1] += ((double)mem1[(MEM_GT + origin) % mem_stride]) * (w[W_COND]) * mem1[(MEM_GT + origin) % mem_stride];
+    }));
+    double g_Hy = sums[0];
+    double g_Hg = sums[1];
 
     float beta = (float)(g_Hy / g_Hg);
 
     if (beta < 0.f || std::isnan(beta))
       beta = 0.f;
 
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      mem[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
+    sums = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+      float* mem1 = mem + i * mem_stride;
+      mem1[(MEM_GT + origin) % mem_stride] = w[W_GT];
 
-      (&(*w))[W_DIR] *= beta;
-      (&(*w))[W_DIR] -= ((&(*w))[W_COND]) * ((&(*w))[W_GT]);
-      (&(*w))[W_GT] = 0;
-    }
+      w[W_DIR] *= beta;
+      w[W_DIR] -= (w[W_COND]) * (w[W_GT]);
+      w[W_GT] = 0;
+      s[0] += ((double)w[W_DIR]) * w[W_DIR];
+    }));
     if (!all.logger.quiet)
       fprintf(stderr, "%f\t", beta);
-    return;
-
-    mem = mem0 + (length - 1) * b.mem_stride;
+    return (float)sums[0];
   }
   else
   {
@@ -313,21 +430,18 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
   }
 
   // implement bfgs
-  double y_s = 0.;
-  double y_Hy = 0.;
-  double s_q = 0.;
-
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    mem1[(MEM_YT + origin) % b.mem_stride] = (&(*w))[W_GT] - mem1[(MEM_GT + origin) % b.mem_stride];
-    mem1[(MEM_ST + origin) % b.mem_stride] = (&(*w))[W_XT] - mem1[(MEM_XT + origin) % b.mem_stride];
-    (&(*w))[W_DIR] = (&(*w))[W_GT];
-    y_s += ((double)mem1[(MEM_YT + origin) % b.mem_stride]) * mem1[(MEM_ST + origin) % b.mem_stride];
-    y_Hy +=
-        ((double)mem1[(MEM_YT + origin) % b.mem_stride]) * mem1[(MEM_YT + origin) % b.mem_stride] * ((&(*w))[W_COND]);
-    s_q += ((double)mem1[(MEM_ST + origin) % b.mem_stride]) * ((&(*w))[W_GT]);
-  }
+  sweep_sums sums = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    float* mem1 = mem + i * mem_stride;
+    mem1[(MEM_YT + origin) % mem_stride] = w[W_GT] - mem1[(MEM_GT + origin) % mem_stride];
+    mem1[(MEM_ST + origin) % mem_stride] = w[W_XT] - mem1[(MEM_XT + origin) % mem_stride];
+    w[W_DIR] = w[W_GT];
+    s[0] += ((double)mem1[(MEM_YT + origin) % mem_stride]) * mem1[(MEM_ST + origin) % mem_stride];
+    s[1] += ((double)mem1[(MEM_YT + origin) % mem_stride]) * mem1[(MEM_YT + origin) % mem_stride] * (w[W_COND]);
+    s[2] += ((double)mem1[(MEM_ST + origin) % mem_stride]) * (w[W_GT]);
+  }));
+  double y_s = sums[0];
+  double y_Hy = sums[1];
+  double s_q = sums[2];
 
   if (y_s <= 0. || y_Hy <= 0.)
     throw curv_ex;
@@ -335,92 +449,88 @@ void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha,
 
   float gamma = (float)(y_s / y_Hy);
 
+  // Each sweep of the two loop recursion applies one axpy to the direction and takes the dot product needed by
+  // the next one.
   for (int j = 0; j < lastj; j++)
   {
     alpha[j] = rho[j] * s_q;
-    s_q = 0.;
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      (&(*w))[W_DIR] -= (float)alpha[j] * mem[(2 * j + MEM_YT + origin) % b.mem_stride];
-      s_q += ((double)mem[(2 * j + 2 + MEM_ST + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-    }
+    const float a = (float)alpha[j];
+    s_q = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+      float* mem1 = mem + i * mem_stride;
+      w[W_DIR] -= a * mem1[(2 * j + MEM_YT + origin) % mem_stride];
+      s[0] += ((double)mem1[(2 * j + 2 + MEM_ST + origin) % mem_stride]) * (w[W_DIR]);
+    }))[0];
   }
 
   alpha[lastj] = rho[lastj] * s_q;
-  double y_r = 0.;
-
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    (&(*w))[W_DIR] -= (float)alpha[lastj] * mem[(2 * lastj + MEM_YT + origin) % b.mem_stride];
-    (&(*w))[W_DIR] *= gamma * ((&(*w))[W_COND]);
-    y_r += ((double)mem[(2 * lastj + MEM_YT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-  }
+  const float a = (float)alpha[lastj];
+  double y_r = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    float* mem1 = mem + i * mem_stride;
+    w[W_DIR] -= a * mem1[(2 * lastj + MEM_YT + origin) % mem_stride];
+    w[W_DIR] *= gamma * (w[W_COND]);
+    s[0] += ((double)mem1[(2 * lastj + MEM_YT + origin) % mem_stride]) * (w[W_DIR]);
+  }))[0];
 
   double coef_j;
 
   for (int j = lastj; j > 0; j--)
   {
     coef_j = alpha[j] - rho[j] * y_r;
-    y_r = 0.;
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-      (&(*w))[W_DIR] += (float)coef_j * mem[(2 * j + MEM_ST + origin) % b.mem_stride];
-      y_r += ((double)mem[(2 * j - 2 + MEM_YT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-    }
-  }
-
-  coef_j = alpha[0] - rho[0] * y_r;
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    (&(*w))[W_DIR] = -(&(*w))[W_DIR] - (float)coef_j * mem[(MEM_ST + origin) % b.mem_stride];
+    const float c = (float)coef_j;
+    y_r = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+      float* mem1 = mem + i * mem_stride;
+      w[W_DIR] += c * mem1[(2 * j + MEM_ST + origin) % mem_stride];
+      s[0] += ((double)mem1[(2 * j - 2 + MEM_YT + origin) % mem_stride]) * (w[W_DIR]);
+    }))[0];
   }
 
   /*********************
   ** shift
   ********************/
 
+  coef_j = alpha[0] - rho[0] * y_r;
+  const float c = (float)coef_j;
+  const int old_origin = origin;
   lastj = (lastj < b.m - 1) ? lastj + 1 : b.m - 1;
-  origin = (origin + b.mem_stride - 2) % b.mem_stride;
-
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    mem = mem0 + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    mem[(MEM_GT + origin) % b.mem_stride] = (&(*w))[W_GT];
-    mem[(MEM_XT + origin) % b.mem_stride] = (&(*w))[W_XT];
-    (&(*w))[W_GT] = 0;
-  }
+  origin = (origin + mem_stride - 2) % mem_stride;
+
+  // the last update of the direction is fused with the shift of the memory
+  sums = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    float* mem1 = mem + i * mem_stride;
+    w[W_DIR] = -w[W_DIR] - c * mem1[(MEM_ST + old_origin) % mem_stride];
+    s[0] += ((double)w[W_DIR]) * w[W_DIR];
+    mem1[(MEM_GT + origin) % mem_stride] = w[W_GT];
+    mem1[(MEM_XT + origin) % mem_stride] = w[W_XT];
+    w[W_GT] = 0;
+  }));
   for (int j = lastj; j > 0; j--) rho[j] = rho[j - 1];
+  return (float)sums[0];
 }
 
-void bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha, int& lastj, int& origin)
+float bfgs_iter_middle(vw& all, bfgs& b, float* mem, double* rho, double* alpha, int& lastj, int& origin)
 {
   if (all.weights.sparse)
-    bfgs_iter_middle(all, b, mem, rho, alpha, lastj, origin, all.weights.sparse_weights);
+    return bfgs_iter_middle(all, b, mem, rho, alpha, lastj, origin, all.weights.sparse_weights);
   else
-    bfgs_iter_middle(all, b, mem, rho, alpha, lastj, origin, all.weights.dense_weights);
+    return bfgs_iter_middle(all, b, mem, rho, alpha, lastj, origin, all.weights.dense_weights);
 }
 
 template <class T>
 double wolfe_eval(vw& all, bfgs& b, float* mem, double loss_sum, double previous_loss_sum, double step_size,
     double importance_weight_sum, int& origin, double& wolfe1, T& weights)
 {
-  double g0_d = 0.;
-  double g1_d = 0.;
-  double g1_Hg1 = 0.;
-  double g1_g1 = 0.;
-
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    g0_d += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * ((&(*w))[W_DIR]);
-    g1_d += ((double)(&(*w))[W_GT]) * (&(*w))[W_DIR];
-    g1_Hg1 += ((double)(&(*w))[W_GT]) * (&(*w))[W_GT] * ((&(*w))[W_COND]);
-    g1_g1 += ((double)(&(*w))[W_GT]) * (&(*w))[W_GT];
-  }
+  const int mem_stride = b.mem_stride;
+  sweep_sums sums = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    float* mem1 = mem + i * mem_stride;
+    s[0] += ((double)mem1[(MEM_GT + origin) % mem_stride]) * (w[W_DIR]);
+    s[1] += ((double)w[W_GT]) * w[W_DIR];
+    s[2] += ((double)w[W_GT]) * w[W_GT] * (w[W_COND]);
+    s[3] += ((double)w[W_GT]) * w[W_GT];
+  }));
+  double g0_d = sums[0];
+  double g1_d = sums[1];
+  double g1_Hg1 = sums[2];
+  double g1_g1 = sums[3];
 
   wolfe1 = (loss_sum - previous_loss_sum) / (step_size * g0_d);
   double wolfe2 = g1_d / g0_d;
@@ -449,20 +559,18 @@ double add_regularization(vw& all, bfgs& b, float regularization, T& weights)
   // compute the derivative difference
   double ret = 0.;
 
-  if (b.regularizers == nullptr)
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      (&(*w))[W_GT] += regularization * (*w);
-      ret += 0.5 * regularization * (*w) * (*w);
-    }
+  const weight* regularizers = b.regularizers;
+  if (regularizers == nullptr)
+    ret = total(sweep(b, weights, [&](float* w, uint64_t, sweep_sums& s) {
+      w[W_GT] += regularization * (*w);
+      s[0] += 0.5 * regularization * (*w) * (*w);
+    }))[0];
   else
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      uint64_t i = w.index() >> weights.stride_shift();
-      weight delta_weight = *w - b.regularizers[2 * i + 1];
-      (&(*w))[W_GT] += b.regularizers[2 * i] * delta_weight;
-      ret += 0.5 * b.regularizers[2 * i] * delta_weight * delta_weight;
-    }
+    ret = total(sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+      weight delta_weight = *w - regularizers[2 * i + 1];
+      w[W_GT] += regularizers[2 * i] * delta_weight;
+      s[0] += 0.5 * regularizers[2 * i] * delta_weight * delta_weight;
+    }))[0];
 
   // if we're not regularizing the intercept term, then subtract it off from the result above
   // when accessing weights[constant], always use weights.strided_index(constant)
@@ -496,34 +604,23 @@ double add_regularization(vw& all, bfgs& b, float regularization)
 template <class T>
 void finalize_preconditioner(vw& /* all */, bfgs& b, float regularization, T& weights)
 {
+  const weight* regularizers = b.regularizers;
+  std::vector<sweep_sums> partials = sweep(b, weights, [&](float* w, uint64_t i, sweep_sums& s) {
+    w[W_COND] += regularizers == nullptr ? regularization : regularizers[2 * i];
+    if (w[W_COND] > s[0])
+      s[0] = w[W_COND];
+    if (w[W_COND] > 0)
+      w[W_COND] = 1.f / w[W_COND];
+  });
   float max_hessian = 0.f;
-
-  if (b.regularizers == nullptr)
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      (&(*w))[W_COND] += regularization;
-      if ((&(*w))[W_COND] > max_hessian)
-        max_hessian = (&(*w))[W_COND];
-      if ((&(*w))[W_COND] > 0)
-        (&(*w))[W_COND] = 1.f / (&(*w))[W_COND];
-    }
-  else
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-    {
-      (&(*w))[W_COND] += b.regularizers[2 * (w.index() >> weights.stride_shift())];
-      if ((&(*w))[W_COND] > max_hessian)
-        max_hessian = (&(*w))[W_COND];
-      if ((&(*w))[W_COND] > 0)
-        (&(*w))[W_COND] = 1.f / (&(*w))[W_COND];
-    }
+  for (const auto& s : partials) max_hessian = std::max(max_hessian, (float)s[0]);
 
   float max_precond = (max_hessian == 0.f) ? 0.f : max_precond_ratio / max_hessian;
 
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
+  sweep(b, weights, [&](float* w, uint64_t, sweep_sums&) {
     if (std::isinf(*w) || *w > max_precond)
-      (&(*w))[W_COND] = max_precond;
-  }
+      w[W_COND] = max_precond;
+  });
 }
 void finalize_preconditioner(vw& all, bfgs& b, float regularization)
 {
@@ -601,38 +698,17 @@ void zero_state(vw& all)
 }
 
 template <class T>
-double derivative_in_direction(vw& /* all */, bfgs& b, float* mem, int& origin, T& weights)
-{
-  double ret = 0.;
-  for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
-  {
-    float* mem1 = mem + (w.index() >> weights.stride_shift()) * b.mem_stride;
-    ret += ((double)mem1[(MEM_GT + origin) % b.mem_stride]) * (&(*w))[W_DIR];
-  }
-  return ret;
-}
-
-double derivative_in_direction(vw& all, bfgs& b, float* mem, int& origin)
-{
-  if (all.weights.sparse)
-    return derivative_in_direction(all, b, mem, origin, all.weights.sparse_weights);
-  else
-    return derivative_in_direction(all, b, mem, origin, all.weights.dense_weights);
-}
-
-template <class T>
-void update_weight(vw& /* all */, float step_size, T& w)
+void update_weight(vw& /* all */, bfgs& b, float step_size, T& weights)
 {
-  for (typename T::iterator iter = w.begin(); iter != w.end(); ++iter)
-    (&(*iter))[W_XT] += step_size * (&(*iter))[W_DIR];
+  sweep(b, weights, [step_size](float* w, uint64_t, sweep_sums&) { w[W_XT] += step_size * w[W_DIR]; });
 }
 
-void update_weight(vw& all, float step_size)
+void update_weight(vw& all, bfgs& b, float step_size)
 {
   if (all.weights.sparse)
-    update_weight(all, step_size, all.weights.sparse_weights);
+    update_weight(all, b, step_size, all.weights.sparse_weights);
   else
-    update_weight(all, step_size, all.weights.dense_weights);
+    update_weight(all, b, step_size, all.weights.dense_weights);
 }
 
 int process_pass(vw& all, bfgs& b)
@@ -667,7 +743,7 @@ int process_pass(vw& all, bfgs& b)
     b.loss_sum = 0.;
     b.example_number = 0;
     b.curvature = 0;
-    bfgs_iter_start(all, b, b.mem, b.lastj, b.importance_weight_sum, b.origin);
+    float d_mag = bfgs_iter_start(all, b, b.mem, b.lastj, b.importance_weight_sum, b.origin);
     if (b.first_hessian_on)
     {
       b.gradient_pass = false;  // now start computing curvature
@@ -675,13 +751,12 @@ int process_pass(vw& all, bfgs& b)
     else
     {
       b.step_size = 0.5;
-      float d_mag = direction_magnitude(all);
       b.t_end_global = std::chrono::system_clock::now();
       b.net_time = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(b.t_end_global - b.t_start_global).count());
       if (!all.logger.quiet)
         fprintf(stderr, "%-10s\t%-10.5f\t%-.5f\n", "", d_mag, b.step_size);
       b.predictions.clear();
-      update_weight(all, b.step_size);
+      update_weight(all, b, b.step_size);
     }
   }
   else
@@ -740,7 +815,7 @@ int process_pass(vw& all, bfgs& b)
       if (!all.logger.quiet)
         fprintf(stderr, "%-10s\t%-10s\t(revise x %.1f)\t%-.5f\n", "", "", ratio, new_step);
       b.predictions.clear();
-      update_weight(all, (float)(-b.step_size + new_step));
+      update_weight(all, b, (float)(-b.step_size + new_step));
       b.step_size = (float)new_step;
       zero_derivative(all);
       b.loss_sum = 0.;
@@ -767,15 +842,17 @@ int process_pass(vw& all, bfgs& b)
       b.curvature = 0;
       b.step_size = 1.0;
 
+      float d_mag;
       try
       {
-        bfgs_iter_middle(all, b, b.mem, b.rho, b.alpha, b.lastj, b.origin);
+        d_mag = bfgs_iter_middle(all, b, b.mem, b.rho, b.alpha, b.lastj, b.origin);
       }
       catch (const curv_exception&)
       {
         fprintf(stdout, "In bfgs_iter_middle: %s", curv_message);
         b.step_size = 0.0;
         status = LEARN_CURV;
+        d_mag = direction_magnitude(all, b);
       }
 
       if (all.hessian_on)
@@ -784,13 +861,12 @@ int process_pass(vw& all, bfgs& b)
       }
       else
       {
-        float d_mag = direction_magnitude(all);
         b.t_end_global = std::chrono::system_clock::now();
         b.net_time = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(b.t_end_global - b.t_start_global).count());
         if (!all.logger.quiet)
           fprintf(stderr, "%-10s\t%-10.5f\t%-.5f\n", "", d_mag, b.step_size);
         b.predictions.clear();
-        update_weight(all, b.step_size);
+        update_weight(all, b, b.step_size);
       }
     }
   }
@@ -805,9 +881,10 @@ int process_pass(vw& all, bfgs& b)
       float t = (float)b.curvature;
       b.curvature = accumulate_scalar(all, t);  // Accumulate curvatures
     }
+    sweep_sums sums = curvature_pass_sums(all, b, b.mem, b.origin, all.l2_lambda > 0. ? all.l2_lambda : 0.f);
     if (all.l2_lambda > 0.)
-      b.curvature += regularizer_direction_magnitude(all, b, all.l2_lambda);
-    float dd = (float)derivative_in_direction(all, b, b.mem, b.origin);
+      b.curvature += sums[0];
+    float dd = (float)sums[1];
     if (b.curvature == 0. && dd != 0.)
     {
       fprintf(stdout, "%s", curv_message);
@@ -823,10 +900,10 @@ int process_pass(vw& all, bfgs& b)
     else
       b.step_size = -dd / (float)b.curvature;
 
-    float d_mag = direction_magnitude(all);
+    float d_mag = (float)sums[2];
 
     b.predictions.clear();
-    update_weight(all, b.step_size);
+    update_weight(all, b, b.step_size);
     b.t_end_global = std::chrono::system_clock::now();
     b.net_time = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(b.t_end_global - b.t_start_global).count());
 
@@ -1089,8 +1166,13 @@ base_learner* bfgs_setup(options_i& options, vw& all)
   bool conjugate_gradient = false;
   bool bfgs_option = false;
   option_group_definition bfgs_outer_options("LBFGS and Conjugate Gradient options");
-  bfgs_outer_options.add(
-      make_option("conjugate_gradient", conjugate_gradient).keep().help("use conjugate gradient based optimization"));
+  bfgs_outer_options
+      .add(make_option("conjugate_gradient", conjugate_gradient)
+               .keep()
+               .help("use conjugate gradient based optimization"))
+      .add(make_option("bfgs_threads", b->threads)
+               .default_value(1)
+               .help("number of threads for the per pass vector operations over dense weights"));
 
   option_group_definition bfgs_inner_options("LBFGS and Conjugate Gradient options");
   bfgs_inner_options.add(make_option("bfgs", bfgs_option).keep().help("use conjugate gradient based optimization"));
@@ -1105,11 +1187,17 @@ base_learner* bfgs_setup(options_i& options, vw& all)
     options.add_and_parse(bfgs_inner_options);
     if (!bfgs_option)
     {
+      if (options.was_supplied("bfgs_threads"))
+        THROW("--bfgs_threads requires --bfgs or --conjugate_gradient");
       return nullptr;
     }
   }
 
   b->all = &all;
+  if (b->threads == 0)
+    b->threads = 1;
+  if (b->threads > 1)
+    b->workers.reset(new sweep_workers(b->threads));
   b->wolfe1_bound = 0.01;
   b->first_hessian_on = true;
   b->first_pass = true;
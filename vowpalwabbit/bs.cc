@@ -27,6 +27,7 @@ struct bs
   std::vector<double>* pred_vec;
   vw* all;  // for raw prediction and loss
   std::shared_ptr<rand_state> _random_state;
+  std::vector<polyprediction> member_preds;  // scratch for multipredict
 
   ~bs() { delete pred_vec; }
 };
@@ -188,24 +189,34 @@ void predict_or_learn(bs& d, single_learner& base, example& ec)
   std::stringstream outputStringStream;
   d.pred_vec->clear();
 
-  for (size_t i = 1; i <= d.B; i++)
+  if (!is_learn && !shouldOutput)
   {
-    ec.weight = weight_temp * (float)BS::weight_gen(d._random_state);
+    // The bootstrap models use disjoint weights, so they are all scored in one multipredict pass over the features.
+    // The importance weights are still drawn to keep the random stream the same as in the per-model loop.
+    for (size_t i = 1; i <= d.B; i++) BS::weight_gen(d._random_state);
+    d.member_preds.resize(d.B);
+    base.multipredict(ec, 0, d.B, d.member_preds.data(), true);
+    for (const auto& pred : d.member_preds) d.pred_vec->push_back(pred.scalar);
+  }
+  else
+    for (size_t i = 1; i <= d.B; i++)
+    {
+      ec.weight = weight_temp * (float)BS::weight_gen(d._random_state);
 
-    if (is_learn)
-      base.learn(ec, i - 1);
-    else
-      base.predict(ec, i - 1);
+      if (is_learn)
+        base.learn(ec, i - 1);
+      else
+        base.predict(ec, i - 1);
 
-    d.pred_vec->push_back(ec.pred.scalar);
+      d.pred_vec->push_back(ec.pred.scalar);
 
-    if (shouldOutput)
-    {
-      if (i > 1)
-        outputStringStream << ' ';
-      outputStringStream << i << ':' << ec.partial_prediction;
+      if (shouldOutput)
+      {
+        if (i > 1)
+          outputStringStream << ' ';
+        outputStringStream << i << ':' << ec.partial_prediction;
+      }
     }
-  }
 
   ec.weight = weight_temp;
 
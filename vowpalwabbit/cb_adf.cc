@@ -44,6 +44,8 @@ struct cb_adf
   v_array<uint32_t> _backup_nf;    // temporary storage for sm; backup for numFeatures in examples
   v_array<float> _backup_weights;  // temporary storage for sm; backup for weights in examples
 
+  std::vector<polyprediction> _model_preds;  // scratch for multipredict
+
   uint64_t _offset;
   const bool _no_predict;
   const bool _rank_all;
@@ -63,6 +65,8 @@ struct cb_adf
 
   void set_scorer(VW::LEARNER::single_learner* scorer) { _gen_cs.scorer = scorer; }
 
+  void multipredict(multi_learner& base, multi_ex& ec_seq, size_t count, size_t increment, polyprediction* pred);
+
   bool get_rank_all() const { return _rank_all; }
 
   const cb_to_cs_adf& get_gen_cs() const { return _gen_cs; }
@@ -336,6 +340,15 @@ void cb_adf::do_actual_learning(multi_learner& base, multi_ex& ec_seq)
   }
 }
 
+void cb_adf::multipredict(
+    multi_learner& base, multi_ex& ec_seq, size_t count, size_t increment, polyprediction* pred)
+{
+  _offset = ec_seq[0]->ft_offset;
+  gen_cs_test_example(ec_seq, _cs_labels);  // create test labels.
+  multipredict_cs_ldf(
+      base, ec_seq, _cb_labels, _cs_labels, _prepped_cs_labels, _offset, count, increment, pred, _model_preds);
+}
+
 void global_print_newline(const std::vector<std::unique_ptr<VW::io::writer>>& final_prediction_sink)
 {
   char temp[1];
@@ -474,6 +487,12 @@ void learn(cb_adf& c, multi_learner& base, multi_ex& ec_seq) { c.do_actual_learn
 
 void predict(cb_adf& c, multi_learner& base, multi_ex& ec_seq) { c.do_actual_learning<false>(base, ec_seq); }
 
+void multipredict(
+    cb_adf& c, multi_learner& base, multi_ex& ec_seq, size_t count, size_t increment, polyprediction* pred, bool)
+{
+  c.multipredict(base, ec_seq, count, increment, pred);
+}
+
 }  // namespace CB_ADF
 using namespace CB_ADF;
 base_learner* cb_adf_setup(options_i& options, vw& all)
@@ -572,6 +591,7 @@ base_learner* cb_adf_setup(options_i& options, vw& all)
   cb_adf* bare = ld.get();
   learner<cb_adf, multi_ex>& l =
       init_learner(ld, base, learn, predict, problem_multiplier, prediction_type_t::action_scores);
+  l.set_multipredict(CB_ADF::multipredict);
   l.set_finish_example(CB_ADF::finish_multiline_example);
 
   bare->set_scorer(all.scorer);
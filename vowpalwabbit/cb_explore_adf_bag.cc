@@ -32,15 +32,17 @@ struct cb_explore_adf_bag
   size_t _bag_size;
   bool _greedify;
   bool _first_only;
+  size_t _top_k;
   std::shared_ptr<rand_state> _random_state;
 
   v_array<ACTION_SCORE::action_score> _action_probs;
   std::vector<float> _scores;
   std::vector<float> _top_actions;
+  std::vector<polyprediction> _member_preds;
 
  public:
-  cb_explore_adf_bag(
-      float epsilon, size_t bag_size, bool greedify, bool first_only, std::shared_ptr<rand_state> random_state);
+  cb_explore_adf_bag(float epsilon, size_t bag_size, bool greedify, bool first_only, size_t top_k,
+      std::shared_ptr<rand_state> random_state);
   ~cb_explore_adf_bag();
 
   // Should be called through cb_explore_adf_base for pre/post-processing
@@ -50,11 +52,17 @@ struct cb_explore_adf_bag
  private:
   template <bool is_learn>
   void predict_or_learn_impl(VW::LEARNER::multi_learner& base, multi_ex& examples);
+  void vote_all_members(VW::LEARNER::multi_learner& base, multi_ex& examples);
 };
 
-cb_explore_adf_bag::cb_explore_adf_bag(
-    float epsilon, size_t bag_size, bool greedify, bool first_only, std::shared_ptr<rand_state> random_state)
-    : _epsilon(epsilon), _bag_size(bag_size), _greedify(greedify), _first_only(first_only), _random_state(random_state)
+cb_explore_adf_bag::cb_explore_adf_bag(float epsilon, size_t bag_size, bool greedify, bool first_only, size_t top_k,
+    std::shared_ptr<rand_state> random_state)
+    : _epsilon(epsilon)
+    , _bag_size(bag_size)
+    , _greedify(greedify)
+    , _first_only(first_only)
+    , _top_k(top_k)
+    , _random_state(random_state)
 {
 }
 
@@ -73,31 +81,34 @@ void cb_explore_adf_bag::predict_or_learn_impl(VW::LEARNER::multi_learner& base,
   _scores.clear();
   for (uint32_t i = 0; i < num_actions; i++) _scores.push_back(0.f);
   _top_actions.assign(num_actions, 0);
-  for (uint32_t i = 0; i < _bag_size; i++)
-  {
-    // avoid updates to the random num generator
-    // for greedify, always update first policy once
-    uint32_t count = is_learn ? ((_greedify && i == 0) ? 1 : BS::weight_gen(_random_state)) : 0;
-
-    if (is_learn && count > 0)
-      VW::LEARNER::multiline_learn_or_predict<true>(base, examples, examples[0]->ft_offset, i);
-    else
-      VW::LEARNER::multiline_learn_or_predict<false>(base, examples, examples[0]->ft_offset, i);
-
-    assert(preds.size() == num_actions);
-    for (auto e : preds) _scores[e.action] += e.score;
-
-    if (!_first_only)
+  if (!is_learn)
+    vote_all_members(base, examples);
+  else
+    for (uint32_t i = 0; i < _bag_size; i++)
     {
-      size_t tied_actions = fill_tied(preds);
-      for (size_t j = 0; j < tied_actions; ++j) _top_actions[preds[j].action] += 1.f / tied_actions;
-    }
-    else
-      _top_actions[preds[0].action] += 1.f;
-    if (is_learn)
-      for (uint32_t j = 1; j < count; j++)
+      // avoid updates to the random num generator
+      // for greedify, always update first policy once
+      uint32_t count = is_learn ? ((_greedify && i == 0) ? 1 : BS::weight_gen(_random_state)) : 0;
+
+      if (is_learn && count > 0)
         VW::LEARNER::multiline_learn_or_predict<true>(base, examples, examples[0]->ft_offset, i);
-  }
+      else
+        VW::LEARNER::multiline_learn_or_predict<false>(base, examples, examples[0]->ft_offset, i);
+
+      assert(preds.size() == num_actions);
+      for (auto e : preds) _scores[e.action] += e.score;
+
+      if (!_first_only)
+      {
+        size_t tied_actions = fill_tied(preds);
+        for (size_t j = 0; j < tied_actions; ++j) _top_actions[preds[j].action] += 1.f / tied_actions;
+      }
+      else
+        _top_actions[preds[0].action] += 1.f;
+      if (is_learn)
+        for (uint32_t j = 1; j < count; j++)
+          VW::LEARNER::multiline_learn_or_predict<true>(base, examples, examples[0]->ft_offset, i);
+    }
 
   _action_probs.clear();
   for (uint32_t i = 0; i < _scores.size(); i++) _action_probs.push_back({i, 0.});
@@ -108,9 +119,47 @@ void cb_explore_adf_bag::predict_or_learn_impl(VW::LEARNER::multi_learner& base,
 
   exploration::enforce_minimum_probability(_epsilon, true, begin_scores(_action_probs), end_scores(_action_probs));
 
-  sort_action_probs(_action_probs, _scores);
+  sort_action_probs(_action_probs, _scores, _top_k);
+
+  preds.clear();
+  for (const auto& as : _action_probs) preds.push_back(as);
+}
+
+// Bag members use disjoint weights, so at prediction time they are all scored with one multipredict pass over the
+// features instead of one prediction per member. The votes match what the sorted per-member predictions give: the
+// actions tied for the lowest score share a vote, or the lowest-index one gets it with --first_only.
+void cb_explore_adf_bag::vote_all_members(VW::LEARNER::multi_learner& base, multi_ex& examples)
+{
+  const size_t num_actions = examples.size();
+  _member_preds.resize(_bag_size * num_actions);
+  base.multipredict(examples, 0, _bag_size, _member_preds.data(), false);
+
+  for (size_t i = 0; i < _bag_size; i++)
+  {
+    const polyprediction* member = _member_preds.data() + i * num_actions;
+    size_t best = 0;
+    size_t tied_actions = 0;
+    for (size_t a = 0; a < num_actions; a++)
+    {
+      _scores[a] += member[a].scalar;
+      if (member[a].scalar < member[best].scalar)
+      {
+        best = a;
+        tied_actions = 1;
+      }
+      else if (member[a].scalar == member[best].scalar)
+        ++tied_actions;
+    }
 
-  for (size_t i = 0; i < num_actions; i++) preds[i] = _action_probs[i];
+    if (!_first_only)
+    {
+      for (size_t a = 0; a < num_actions; a++)
+        if (member[a].scalar == member[best].scalar)
+          _top_actions[a] += 1.f / tied_actions;
+    }
+    else
+      _top_actions[best] += 1.f;
+  }
 }
 
 cb_explore_adf_bag::~cb_explore_adf_bag() { _action_probs.delete_v(); }
@@ -119,6 +168,7 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all)
 {
   using config::make_option;
   bool cb_explore_adf_option = false;
+  uint32_t top_k = 0;
   float epsilon = 0.;
   size_t bag_size = 0;
   bool greedify = false;
@@ -128,6 +178,7 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all)
       .add(make_option("cb_explore_adf", cb_explore_adf_option)
                .keep()
                .help("Online explore-exploit for a contextual bandit problem with multiline action dependent features"))
+      .add(make_top_k_option(top_k))
       .add(make_option("epsilon", epsilon).keep().allow_override().help("epsilon-greedy exploration"))
       .add(make_option("bag", bag_size).keep().help("bagging-based exploration"))
       .add(make_option("greedify", greedify).keep().help("always update first policy once in bagging"))
@@ -151,7 +202,8 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all)
   all.label_type = label_type_t::cb;
 
   using explore_type = cb_explore_adf_base<cb_explore_adf_bag>;
-  auto data = scoped_calloc_or_throw<explore_type>(epsilon, bag_size, greedify, first_only, all.get_random_state());
+  auto data = scoped_calloc_or_throw<explore_type>(
+      epsilon, bag_size, greedify, first_only, top_k, all.get_random_state());
 
   VW::LEARNER::learner<explore_type, multi_ex>& l = VW::LEARNER::init_learner(
       data, base, explore_type::learn, explore_type::predict, problem_multiplier, prediction_type_t::action_probs);
@@ -5,6 +5,8 @@
 #pragma once
 #include <cstdint>
 #include <algorithm>
+#include <functional>
+#include <vector>
 
 // Most of these includes are required because templated functions are using the objects defined in them
 // A few options to get rid of them:
@@ -18,6 +20,7 @@
 #include "cb_adf.h"          // used for function call in predict/learn
 #include "example.h"         // used in predict
 #include "gen_cs_example.h"  // required for GEN_CS::cb_to_cs_adf
+#include "options.h"         // used in make_top_k_option
 #include "reductions_fwd.h"
 
 namespace VW
@@ -25,25 +28,103 @@ namespace VW
 namespace cb_explore_adf
 {
 // Free functions
-inline void sort_action_probs(v_array<ACTION_SCORE::action_score>& probs, const std::vector<float>& scores)
+
+// Cuts preds to its first top_k entries and renormalizes their probabilities, which leaves a sparse pdf over the
+// action set where every action that is not listed has probability zero.
+inline void cut_to_top_k(v_array<ACTION_SCORE::action_score>& preds, size_t top_k)
+{
+  preds.end() = preds.begin() + top_k;
+  float total = 0.f;
+  for (const auto& as : preds) total += as.score;
+  if (total > 0.f)
+    for (auto& as : preds) as.score /= total;
+}
+
+// Sorts probs by decreasing probability. With a top_k between 1 and the number of actions, only the top_k first
+// entries are selected, with a partial sort, and cut_to_top_k is applied to them.
+inline void sort_action_probs(
+    v_array<ACTION_SCORE::action_score>& probs, const std::vector<float>& scores, size_t top_k = 0)
 {
   // We want to preserve the score order in the returned action_probs if possible.  To do this,
   // sort top_actions and action_probs by the order induced in scores.
-  std::sort(probs.begin(), probs.end(),
-      [&scores](const ACTION_SCORE::action_score& as1, const ACTION_SCORE::action_score& as2) {
-        if (as1.score > as2.score)
-          return true;
-        else if (as1.score < as2.score)
-          return false;
-        // equal probabilities
-        if (scores[as1.action] < scores[as2.action])
-          return true;
-        else if (scores[as1.action] > scores[as2.action])
-          return false;
-        // equal probabilities and equal cost estimates
-        return as1.action < as2.action;
-      });
+  auto cmp = [&scores](const ACTION_SCORE::action_score& as1, const ACTION_SCORE::action_score& as2) {
+    if (as1.score > as2.score)
+      return true;
+    else if (as1.score < as2.score)
+      return false;
+    // equal probabilities
+    if (scores[as1.action] < scores[as2.action])
+      return true;
+    else if (scores[as1.action] > scores[as2.action])
+      return false;
+    // equal probabilities and equal cost estimates
+    return as1.action < as2.action;
+  };
+
+  if (top_k == 0 || top_k >= probs.size())
+  {
+    std::sort(probs.begin(), probs.end(), cmp);
+    return;
+  }
+  std::partial_sort(probs.begin(), probs.begin() + top_k, probs.end(), cmp);
+  cut_to_top_k(probs, top_k);
 }
+
+// Keeps the top_k most probable actions of preds, actions of equal probability in their relative order, and applies
+// cut_to_top_k. Greedy, softmax and first leave preds ranked by decreasing probability, so after a check this is only
+// the cut. Otherwise the top_k-th probability is found with nth_element and the kept entries are sorted. Bag and cover
+// select their top_k in sort_action_probs instead and do not call this.
+inline void keep_top_k(v_array<ACTION_SCORE::action_score>& preds, size_t top_k, std::vector<float>& scratch)
+{
+  if (top_k == 0 || top_k >= preds.size())
+    return;
+
+  auto more_probable = [](const ACTION_SCORE::action_score& as1, const ACTION_SCORE::action_score& as2) {
+    return as1.score > as2.score;
+  };
+  if (std::is_sorted(preds.begin(), preds.end(), more_probable))
+  {
+    cut_to_top_k(preds, top_k);
+    return;
+  }
+
+  // Find the probability of the top_k-th action.
+  scratch.clear();
+  for (const auto& as : preds) scratch.push_back(as.score);
+  std::nth_element(scratch.begin(), scratch.begin() + (top_k - 1), scratch.end(), std::greater<float>());
+  const float threshold = scratch[top_k - 1];
+  size_t num_above = 0;
+  for (const auto& as : preds)
+    if (as.score > threshold)
+      ++num_above;
+
+  // Compact in place: everything above the threshold, then ties in rank order until top_k entries are kept.
+  size_t ties_left = top_k - num_above;
+  size_t kept = 0;
+  for (size_t i = 0; i < preds.size() && kept < top_k; ++i)
+  {
+    bool keep = preds[i].score > threshold;
+    if (!keep && preds[i].score == threshold && ties_left > 0)
+    {
+      keep = true;
+      --ties_left;
+    }
+    if (keep)
+      preds[kept++] = preds[i];
+  }
+
+  std::stable_sort(preds.begin(), preds.begin() + kept, more_probable);
+  cut_to_top_k(preds, kept);
+}
+
+// --cb_explore_top_k, added by every cb_explore_adf setup and handed to cb_explore_adf_base::set_top_k, or to the
+// bag and cover explorers, which apply it in sort_action_probs.
+inline VW::config::typed_option<uint32_t> make_top_k_option(uint32_t& top_k)
+{
+  return VW::config::make_option("cb_explore_top_k", top_k)
+      .help("Only return the top k ranked actions with renormalized probabilities, 0 returns all");
+}
+
 inline size_t fill_tied(v_array<ACTION_SCORE::action_score>& preds)
 {
   if (preds.size() == 0)
@@ -68,12 +149,16 @@ struct cb_explore_adf_base
   CB::label _action_label;
   CB::label _empty_label;
   ExploreType explore;
+  // Number of ranked actions returned, 0 returns all of them.
+  uint32_t _top_k = 0;
+  std::vector<float> _top_k_scratch;
 
  public:
   template <typename... Args>
   cb_explore_adf_base(Args&&... args) : explore(std::forward<Args>(args)...)
   {
   }
+  void set_top_k(uint32_t top_k) { _top_k = top_k; }
   static void finish_multiline_example(vw& all, cb_explore_adf_base<ExploreType>& data, multi_ex& ec_seq);
   static void predict(cb_explore_adf_base<ExploreType>& data, VW::LEARNER::multi_learner& base, multi_ex& examples);
   static void learn(cb_explore_adf_base<ExploreType>& data, VW::LEARNER::multi_learner& base, multi_ex& examples);
@@ -98,6 +183,7 @@ inline void cb_explore_adf_base<ExploreType>::predict(
   }
 
   data.explore.predict(base, examples);
+  keep_top_k(examples[0]->pred.a_s, data._top_k, data._top_k_scratch);
 
   if (label_example != nullptr)
   {
@@ -116,6 +202,7 @@ inline void cb_explore_adf_base<ExploreType>::learn(
     data._known_cost = CB_ADF::get_observed_cost(examples);
     // learn iff label_example != nullptr
     data.explore.learn(base, examples);
+    keep_top_k(examples[0]->pred.a_s, data._top_k, data._top_k_scratch);
   }
   else
   {
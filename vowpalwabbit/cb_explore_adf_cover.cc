@@ -30,6 +30,7 @@ struct cb_explore_adf_cover
   float _psi;
   bool _nounif;
   bool _first_only;
+  size_t _top_k;
   size_t _counter;
   VW::LEARNER::multi_learner* _cs_ldf_learner;
   GEN_CS::cb_to_cs_adf _gen_cs;
@@ -42,7 +43,7 @@ struct cb_explore_adf_cover
   v_array<CB::label> _cb_labels;
 
  public:
-  cb_explore_adf_cover(size_t cover_size, float psi, bool nounif, bool first_only,
+  cb_explore_adf_cover(size_t cover_size, float psi, bool nounif, bool first_only, size_t top_k,
       VW::LEARNER::multi_learner* cs_ldf_learner, VW::LEARNER::single_learner* scorer, size_t cb_type);
   ~cb_explore_adf_cover();
 
@@ -55,9 +56,14 @@ struct cb_explore_adf_cover
   void predict_or_learn_impl(VW::LEARNER::multi_learner& base, multi_ex& examples);
 };
 
-cb_explore_adf_cover::cb_explore_adf_cover(size_t cover_size, float psi, bool nounif, bool first_only,
+cb_explore_adf_cover::cb_explore_adf_cover(size_t cover_size, float psi, bool nounif, bool first_only, size_t top_k,
     VW::LEARNER::multi_learner* cs_ldf_learner, VW::LEARNER::single_learner* scorer, size_t cb_type)
-    : _cover_size(cover_size), _psi(psi), _nounif(nounif), _first_only(first_only), _cs_ldf_learner(cs_ldf_learner)
+    : _cover_size(cover_size)
+    , _psi(psi)
+    , _nounif(nounif)
+    , _first_only(first_only)
+    , _top_k(top_k)
+    , _cs_ldf_learner(cs_ldf_learner)
 {
   _gen_cs.cb_type = cb_type;
   _gen_cs.scorer = scorer;
@@ -157,8 +163,9 @@ void cb_explore_adf_cover::predict_or_learn_impl(VW::LEARNER::multi_learner& bas
   exploration::enforce_minimum_probability(
       min_prob * num_actions, !_nounif, begin_scores(_action_probs), end_scores(_action_probs));
 
-  sort_action_probs(_action_probs, _scores);
-  for (size_t i = 0; i < num_actions; i++) preds[i] = _action_probs[i];
+  sort_action_probs(_action_probs, _scores, _top_k);
+  preds.clear();
+  for (const auto& as : _action_probs) preds.push_back(as);
 
   if (is_learn)
     ++_counter;
@@ -180,6 +187,7 @@ VW::LEARNER::base_learner* setup(config::options_i& options, vw& all)
   using config::make_option;
 
   bool cb_explore_adf_option = false;
+  uint32_t top_k = 0;
   std::string type_string = "mtr";
   size_t cover_size = 0;
   float psi = 0.;
@@ -191,6 +199,7 @@ VW::LEARNER::base_learner* setup(config::options_i& options, vw& all)
       .add(make_option("cb_explore_adf", cb_explore_adf_option)
                .keep()
                .help("Online explore-exploit for a contextual bandit problem with multiline action dependent features"))
+      .add(make_top_k_option(top_k))
       .add(make_option("cover", cover_size).keep().help("Online cover based exploration"))
       .add(make_option("psi", psi).keep().default_value(1.0f).help("disagreement parameter for cover"))
       .add(make_option("nounif", nounif).keep().help("do not explore uniformly on zero-probability actions in cover"))
@@ -246,7 +255,7 @@ VW::LEARNER::base_learner* setup(config::options_i& options, vw& all)
 
   using explore_type = cb_explore_adf_base<cb_explore_adf_cover>;
   auto data = scoped_calloc_or_throw<explore_type>(
-      cover_size, psi, nounif, first_only, as_multiline(all.cost_sensitive), all.scorer, cb_type_enum);
+      cover_size, psi, nounif, first_only, top_k, as_multiline(all.cost_sensitive), all.scorer, cb_type_enum);
 
   VW::LEARNER::learner<explore_type, multi_ex>& l = init_learner(
       data, base, explore_type::learn, explore_type::predict, problem_multiplier, prediction_type_t::action_probs);
@@ -71,6 +71,7 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all)
 {
   using config::make_option;
   bool cb_explore_adf_option = false;
+  uint32_t top_k = 0;
   float epsilon = 0.;
   bool first_only = false;
 
@@ -79,6 +80,7 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all)
       .add(make_option("cb_explore_adf", cb_explore_adf_option)
                .keep()
                .help("Online explore-exploit for a contextual bandit problem with multiline action dependent features"))
+      .add(make_top_k_option(top_k))
       .add(make_option("epsilon", epsilon).keep().allow_override().help("epsilon-greedy exploration"))
       .add(make_option("first_only", first_only).keep().help("Only explore the first action in a tie-breaking event"));
   options.add_and_parse(new_options);
@@ -121,6 +123,8 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all)
     THROW("The value of epsilon must be in [0,1]");
   }
 
+  data->set_top_k(top_k);
+
   VW::LEARNER::learner<explore_type, multi_ex>& l = VW::LEARNER::init_learner(
       data, base, explore_type::learn, explore_type::predict, problem_multiplier, prediction_type_t::action_probs);
 
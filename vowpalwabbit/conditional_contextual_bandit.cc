@@ -31,6 +31,17 @@ void return_v_array(v_array<T>& array, VW::v_array_pool<T>& pool)
   pool.return_object(array);
 }
 
+// A slot namespace injected into the shared example.
+struct injected_namespace
+{
+  namespace_index ns;
+  // Set if the shared feature group refers to the slot's features instead of holding a copy. The shared example's
+  // own (empty) arrays are kept here until they are restored.
+  bool is_view;
+  v_array<feature_value> own_values;
+  v_array<feature_index> own_indicies;
+};
+
 struct ccb
 {
   vw* all;
@@ -41,10 +52,15 @@ struct ccb
   std::vector<bool> exclude_list, include_list;
   std::vector<std::vector<namespace_index>> generated_interactions;
   std::vector<std::vector<namespace_index>>* original_interactions;
+  // Printable namespaces of the decision in first seen order. The generated interactions are a function of these
+  // alone, so they are only rebuilt when the namespaces change between decisions.
+  std::vector<namespace_index> interaction_namespaces, cached_interaction_namespaces;
+  bool interactions_cached = false;
   std::vector<CCB::label> stored_labels;
   size_t action_with_label;
 
   multi_ex cb_ex;
+  std::vector<injected_namespace> injected;
 
   // All of these hashes are with a hasher seeded with the below namespace hash.
   std::vector<uint64_t> slot_id_hashes;
@@ -192,8 +208,11 @@ bool has_action(multi_ex& cb_ex) { return !cb_ex.empty(); }
 // the output_example function has special logic to ensure the number of feaures is correctly calculated.
 // Copy anything in default namespace for slot to ccb_slot_namespace in shared
 // Copy other slot namespaces to shared
-void inject_slot_features(example* shared, example* slot)
+// Namespaces the shared example does not use are not copied: the shared feature group is pointed at the slot's
+// arrays for the duration of the slot.
+void inject_slot_features(ccb& data, example* shared, example* slot)
 {
+  data.injected.clear();
   for (auto index : slot->indices)
   {
     // constant namespace should be ignored, as it already exists and we don't want to double it up.
@@ -202,14 +221,29 @@ void inject_slot_features(example* shared, example* slot)
       continue;
     }
 
-    if (index == default_namespace)  // slot default namespace has a special namespace in shared
+    // slot default namespace has a special namespace in shared
+    const namespace_index shared_index = index == default_namespace ? ccb_slot_namespace : index;
+    features& slot_fs = slot->feature_space[index];
+    features& fs = shared->feature_space[shared_index];
+    injected_namespace injected{shared_index, false, fs.values, fs.indicies};
+    if (fs.nonempty() || !fs.space_names.empty() || !slot_fs.space_names.empty())
     {
-      LabelDict::add_example_namespace(*shared, ccb_slot_namespace, slot->feature_space[default_namespace]);
+      LabelDict::add_example_namespace(*shared, shared_index, slot_fs);
     }
     else
     {
-      LabelDict::add_example_namespace(*shared, index, slot->feature_space[index]);
+      injected.is_view = true;
+      if (std::find(shared->indices.begin(), shared->indices.end(), shared_index) == shared->indices.end())
+      {
+        shared->indices.push_back(shared_index);
+      }
+      fs.values = slot_fs.values;
+      fs.indicies = slot_fs.indicies;
+      fs.sum_feat_sq = slot_fs.sum_feat_sq;
+      shared->total_sum_feat_sq += slot_fs.sum_feat_sq;
+      shared->num_features += slot_fs.size();
     }
+    data.injected.push_back(injected);
   }
 }
 
@@ -262,25 +296,31 @@ void remove_slot_id(example* shared)
   }
 }
 
-void remove_slot_features(example* shared, example* slot)
+// Undo inject_slot_features, last injected namespace first.
+void remove_slot_features(ccb& data, example* shared, example* slot)
 {
-  for (auto index : slot->indices)
+  for (auto injected = data.injected.rbegin(); injected != data.injected.rend(); ++injected)
   {
-    // constant namespace should be ignored, as it already exists and we don't want to double it up.
-    if (index == constant_namespace)
+    const namespace_index slot_index = injected->ns == ccb_slot_namespace ? default_namespace : injected->ns;
+    features& slot_fs = slot->feature_space[slot_index];
+    if (!injected->is_view)
     {
+      LabelDict::del_example_namespace(*shared, injected->ns, slot_fs);
       continue;
     }
 
-    if (index == default_namespace)  // slot default namespace has a special namespace in shared
+    features& fs = shared->feature_space[injected->ns];
+    if (shared->indices.last() == injected->ns)
     {
-      LabelDict::del_example_namespace(*shared, ccb_slot_namespace, slot->feature_space[default_namespace]);
-    }
-    else
-    {
-      LabelDict::del_example_namespace(*shared, index, slot->feature_space[index]);
+      shared->indices.pop();
     }
+    fs.values = injected->own_values;
+    fs.indicies = injected->own_indicies;
+    fs.sum_feat_sq = 0.f;
+    shared->total_sum_feat_sq -= slot_fs.sum_feat_sq;
+    shared->num_features -= slot_fs.size();
   }
+  data.injected.clear();
 }
 
 // Generates quadratics between each namespace and the slot id as well as appends slot id to every existing interaction.
@@ -321,20 +361,73 @@ void calculate_and_insert_interactions(example* shared, const std::vector<exampl
   }
 }
 
+// Collects the printable namespaces that calculate_and_insert_interactions crosses with the slot id, in the same order.
+void collect_interaction_namespaces(
+    example* shared, const std::vector<example*>& actions, std::vector<namespace_index>& namespaces)
+{
+  std::bitset<INTERACTIONS::printable_ns_size> found_namespaces;
+  namespaces.clear();
+
+  auto collect = [&](namespace_index index) {
+    if (INTERACTIONS::is_printable_namespace(index) && !found_namespaces[index - INTERACTIONS::printable_start])
+    {
+      found_namespaces[index - INTERACTIONS::printable_start] = true;
+      namespaces.push_back(index);
+    }
+  };
+  for (const auto& action : actions)
+    for (const auto& action_index : action->indices) collect(action_index);
+  for (const auto& shared_index : shared->indices) collect(shared_index);
+}
+
+template <bool is_learn>
+void add_action_to_cb_example(multi_ex& cb_ex, example* slot, ccb& data, uint32_t i, uint32_t& index)
+{
+  // Select the action
+  cb_ex.push_back(data.actions[i]);
+
+  // Save the original index from the root multi-example
+  data.origin_index[index++] = i;
+
+  // Remember the index of the chosen action
+  const auto* outcome = slot->l.conditional_contextual_bandit.outcome;
+  if (is_learn && outcome != nullptr && i == outcome->probabilities[0].action)
+  {
+    // This is used to remove the label later.
+    data.action_with_label = i;
+    attach_label_to_example(index, data.actions[i], slot->l.conditional_contextual_bandit.outcome, data);
+  }
+}
+
 // build a cb example from the ccb example
 template <bool is_learn>
 void build_cb_example(multi_ex& cb_ex, example* slot, ccb& data)
 {
-  bool slot_has_label = slot->l.conditional_contextual_bandit.outcome != nullptr;
-
   // Merge the slot features with the shared example and set it in the cb multi-example
   // TODO is it imporant for total_sum_feat_sq and num_features to be correct at this point?
-  inject_slot_features(data.shared, slot);
+  inject_slot_features(data, data.shared, slot);
   cb_ex.push_back(data.shared);
 
   // Retrieve the list of actions explicitly available for the slot (if the list is empty, then all actions are possible)
   auto& explicit_includes = slot->l.conditional_contextual_bandit.explicit_included_actions;
-  if (!explicit_includes.empty())
+  data.origin_index.clear();
+
+  // When the included actions are listed in order, as they are for slates where every slot has its own partition of
+  // the actions, they are visited directly instead of scanning every action.
+  const bool sorted_includes = !explicit_includes.empty() &&
+      std::is_sorted(explicit_includes.begin(), explicit_includes.end(), std::less_equal<uint32_t>()) &&
+      explicit_includes.last() < data.actions.size();
+  if (sorted_includes)
+  {
+    data.origin_index.resize(explicit_includes.size(), 0);
+    uint32_t index = 0;
+    for (uint32_t i : explicit_includes)
+    {
+      if (!data.exclude_list[i])
+        add_action_to_cb_example<is_learn>(cb_ex, slot, data, i, index);
+    }
+  }
+  else if (!explicit_includes.empty())
   {
     // First time seeing this, initialize the vector with falses so we can start setting each included action.
     if (data.include_list.empty())
@@ -349,35 +442,25 @@ void build_cb_example(multi_ex& cb_ex, example* slot, ccb& data)
   }
 
   // set the available actions in the cb multi-example
-  uint32_t index = 0;
-  data.origin_index.clear();
-  data.origin_index.resize(data.actions.size(), 0);
-  for (size_t i = 0; i < data.actions.size(); i++)
+  if (!sorted_includes)
   {
-    // Filter actions that are not explicitly included. If the list is empty though, everything is included.
-    if (!data.include_list.empty() && !data.include_list[i])
+    data.origin_index.resize(data.actions.size(), 0);
+    uint32_t index = 0;
+    for (size_t i = 0; i < data.actions.size(); i++)
     {
-      continue;
-    }
-
-    // Filter actions chosen by previous slots
-    if (data.exclude_list[i])
-    {
-      continue;
-    }
-
-    // Select the action
-    cb_ex.push_back(data.actions[i]);
+      // Filter actions that are not explicitly included. If the list is empty though, everything is included.
+      if (!data.include_list.empty() && !data.include_list[i])
+      {
+        continue;
+      }
 
-    // Save the original index from the root multi-example
-    data.origin_index[index++] = (uint32_t)i;
+      // Filter actions chosen by previous slots
+      if (data.exclude_list[i])
+      {
+        continue;
+      }
 
-    // Remember the index of the chosen action
-    if (is_learn && slot_has_label && i == slot->l.conditional_contextual_bandit.outcome->probabilities[0].action)
-    {
-      // This is used to remove the label later.
-      data.action_with_label = (uint32_t)i;
-      attach_label_to_example(index, data.actions[i], slot->l.conditional_contextual_bandit.outcome, data);
+      add_action_to_cb_example<is_learn>(cb_ex, slot, data, (uint32_t)i, index);
     }
   }
 
@@ -416,21 +499,28 @@ void learn_or_predict(ccb& data, multi_learner& base, multi_ex& examples)
 
   auto decision_scores = examples[0]->pred.decision_scores;
 
-  // for each slot, re-build the cb example and call cb_explore_adf
-  size_t slot_id = 0;
-  for (example* slot : data.slots)
+  // Namespace crossing for slot features. The crossings only depend on the shared and action namespaces, so they are
+  // the same for every slot.
+  collect_interaction_namespaces(data.shared, data.actions, data.interaction_namespaces);
+  if (!data.interactions_cached || data.interaction_namespaces != data.cached_interaction_namespaces)
   {
-    // Namespace crossing for slot features.
     data.generated_interactions.clear();
     std::copy(data.original_interactions->begin(), data.original_interactions->end(),
         std::back_inserter(data.generated_interactions));
     calculate_and_insert_interactions(data.shared, data.actions, data.generated_interactions);
-    data.shared->interactions = &data.generated_interactions;
-    for (auto* ex : data.actions)
-    {
-      ex->interactions = &data.generated_interactions;
-    }
+    data.cached_interaction_namespaces = data.interaction_namespaces;
+    data.interactions_cached = true;
+  }
+  data.shared->interactions = &data.generated_interactions;
+  for (auto* ex : data.actions)
+  {
+    ex->interactions = &data.generated_interactions;
+  }
 
+  // for each slot, re-build the cb example and call cb_explore_adf
+  size_t slot_id = 0;
+  for (example* slot : data.slots)
+  {
     data.include_list.clear();
     build_cb_example<is_learn>(data.cb_ex, slot, data);
 
@@ -456,13 +546,7 @@ void learn_or_predict(ccb& data, multi_learner& base, multi_ex& examples)
       decision_scores.push_back(data.action_score_pool.get_object());
     }
 
-    data.shared->interactions = data.original_interactions;
-    for (auto* ex : data.actions)
-    {
-      ex->interactions = data.original_interactions;
-    }
-    remove_slot_features(data.shared, slot);
-
+    // the slot id was injected last, so it is removed first and the slot namespaces are at the end of the indices again
     if (data.all->audit)
     {
       remove_slot_id<true>(data.shared);
@@ -472,12 +556,20 @@ void learn_or_predict(ccb& data, multi_learner& base, multi_ex& examples)
       remove_slot_id<false>(data.shared);
     }
 
+    remove_slot_features(data, data.shared, slot);
+
     // Put back the original shared example tag.
     std::swap(data.shared->tag, slot->tag);
     slot_id++;
     data.cb_ex.clear();
   }
 
+  data.shared->interactions = data.original_interactions;
+  for (auto* ex : data.actions)
+  {
+    ex->interactions = data.original_interactions;
+  }
+
   delete_cb_labels(data);
 
   // Restore ccb labels to the example objects.
@@ -522,14 +614,16 @@ std::string generate_ccb_label_printout(const std::vector<example*>& slots)
   return label_ss.str();
 }
 
-void output_example(vw& all, ccb& /*c*/, multi_ex& ec_seq)
+void output_example(vw& all, ccb& data, multi_ex& ec_seq)
 {
   if (ec_seq.empty())
   {
     return;
   }
 
-  std::vector<example*> slots;
+  // the slots of the decision are collected again, into the vector learn_or_predict already sized for them
+  auto& slots = data.slots;
+  slots.clear();
   size_t num_features = 0;
   float loss = 0.;
 
@@ -9,9 +9,11 @@
 #include "label_dictionary.h"
 #include "vw.h"
 #include "gd.h"  // GD::foreach_feature() needed in subtract_example()
+#include "scorer.h"
 #include "vw_exception.h"
 #include <algorithm>
 #include "csoaa.h"
+#include "shared_feature_merger.h"
 #include "scope_exit.h"
 
 using namespace VW::LEARNER;
@@ -23,7 +25,9 @@ namespace CSOAA
 struct csoaa
 {
   uint32_t num_classes;
-  polyprediction* pred;
+  polyprediction* pred;  // scratch for learn_all_classes
+  vw* all;
+  bool batch_learn;
   ~csoaa() { free(pred); }
 };
 
@@ -51,6 +55,73 @@ inline void inner_loop(single_learner& base, example& ec, uint32_t i, float cost
 
 #define DO_MULTIPREDICT true
 
+// Is the learner just set up below a reduction the identity scorer directly over gd? Then a raw prediction is a dot
+// product with the weights and update is gd's update, which the batched paths below rely on.
+bool base_is_linear_gd(vw& all)
+{
+  const auto& below = all.enabled_reductions;
+  return below.size() == 2 && below[0] == GD::setup && below[1] == scorer_setup &&
+      all.options->get_typed_option<std::string>("link").value() == "identity";
+}
+
+// csoaa, or csoaa_ldf under the shared feature merger, directly over the scorer and gd only write their predictions
+// to the examples and to per thread scratch. Sparse weights insert on lookup, audit prints, and ranking or factoring
+// shared namespaces keep their state in ldf.
+bool predict_is_thread_safe(vw& all)
+{
+  const auto& below = all.enabled_reductions;
+  if (below.size() < 3 || below[0] != GD::setup || below[1] != scorer_setup || all.weights.sparse || all.audit ||
+      all.hash_inv)
+    return false;
+  if (below.size() == 3 && below[2] == csoaa_setup)
+    return true;
+  const bool ldf_on_top = below.size() == 3 ||
+      (below.size() == 4 && below[3] == VW::shared_feature_merger::shared_feature_merger_setup);
+  return ldf_on_top && below[2] == csldf_setup && !all.options->was_supplied("csoaa_rank") &&
+      !all.options->was_supplied("ldf_factor_shared");
+}
+
+// --csoaa_batch_learn: learns the labelled classes with one multipredict pass followed by an update per class,
+// instead of a full learn (predict and update) per class. Every class is scored before any of them is updated, so
+// the result only matches the per class loop when no feature of one class hashes onto a weight of another, and the
+// weights are not being truncated or contracted by l1/l2.
+void learn_all_classes(csoaa& c, single_learner& base, example& ec, label& ld, uint32_t& prediction, float& score)
+{
+  vw& all = *c.all;
+  ec.l.simple = {FLT_MAX, 0.f, 0.f};
+  base.multipredict(ec, 0, c.num_classes, c.pred, false);
+  for (auto& cl : ld.costs)
+  {
+    const uint32_t i = cl.class_index;
+    const float raw = c.pred[i - 1].scalar;
+    ec.weight = (cl.x == FLT_MAX) ? 0.f : 1.f;
+    ec.l.simple.label = cl.x;
+    all.set_minmax(all.sd, cl.x);
+    ec.partial_prediction = raw;
+    if (cl.x != FLT_MAX)
+    {
+      ec.pred.scalar = GD::finalize_prediction(all.sd, all.logger, raw);
+      base.update(ec, i - 1);
+    }
+
+    cl.partial_prediction = raw;
+    if (raw < score || (raw == score && i < prediction))
+    {
+      score = raw;
+      prediction = i;
+    }
+    add_passthrough_feature(ec, i, raw);
+  }
+}
+
+inline bool can_learn_all_classes(csoaa& c, const label& ld)
+{
+  // scoring every class only pays off if most of them are labelled
+  return c.batch_learn && c.all->sd->contraction == 1. && c.all->sd->gravity == 0. && 2 * ld.costs.size() >= c.num_classes &&
+      std::all_of(ld.costs.cbegin(), ld.costs.cend(),
+          [&c](const wclass& cl) { return cl.class_index >= 1 && cl.class_index <= c.num_classes; });
+}
+
 template <bool is_learn>
 void predict_or_learn(csoaa& c, single_learner& base, example& ec)
 {
@@ -66,21 +137,27 @@ void predict_or_learn(csoaa& c, single_learner& base, example& ec)
   ec.l.simple = {0., 0., 0.};
   if (!ld.costs.empty())
   {
-    for (auto& cl : ld.costs)
-      inner_loop<is_learn>(base, ec, cl.class_index, cl.x, prediction, score, cl.partial_prediction);
+    if (is_learn && can_learn_all_classes(c, ld))
+      learn_all_classes(c, base, ec, ld, prediction, score);
+    else
+      for (auto& cl : ld.costs)
+        inner_loop<is_learn>(base, ec, cl.class_index, cl.x, prediction, score, cl.partial_prediction);
     ec.partial_prediction = score;
   }
   else if (DO_MULTIPREDICT && !is_learn)
   {
+    // per thread rather than c.pred, so that --search_rollout_threads can predict without a lock
+    static thread_local std::vector<polyprediction> pred;
+    pred.resize(c.num_classes);
     ec.l.simple = {FLT_MAX, 0.f, 0.f};
-    base.multipredict(ec, 0, c.num_classes, c.pred, false);
+    base.multipredict(ec, 0, c.num_classes, pred.data(), false);
     for (uint32_t i = 1; i <= c.num_classes; i++)
     {
-      add_passthrough_feature(ec, i, c.pred[i - 1].scalar);
-      if (c.pred[i - 1].scalar < c.pred[prediction - 1].scalar)
+      add_passthrough_feature(ec, i, pred[i - 1].scalar);
+      if (pred[i - 1].scalar < pred[prediction - 1].scalar)
         prediction = i;
     }
-    ec.partial_prediction = c.pred[prediction - 1].scalar;
+    ec.partial_prediction = pred[prediction - 1].scalar;
   }
   else
   {
@@ -120,15 +197,27 @@ base_learner* csoaa_setup(options_i& options, vw& all)
   auto c = scoped_calloc_or_throw<csoaa>();
   option_group_definition new_options("Cost Sensitive One Against All");
   new_options.add(make_option("csoaa", c->num_classes).keep().help("One-against-all multiclass with <k> costs"));
+  new_options.add(make_option("csoaa_batch_learn", c->batch_learn)
+                      .help("Learn all labelled classes from one multipredict pass when most classes are labelled. "
+                            "Needs a plain gd base learner. Classes whose features collide in the weight table "
+                            "can learn differently than without it."));
   options.add_and_parse(new_options);
 
   if (!options.was_supplied("csoaa"))
     return nullptr;
 
   c->pred = calloc_or_throw<polyprediction>(c->num_classes);
+  c->all = &all;
 
-  learner<csoaa, example>& l = init_learner(c, as_singleline(setup_base(*all.options, all)), predict_or_learn<true>,
-      predict_or_learn<false>, c->num_classes, prediction_type_t::multiclass);
+  single_learner* base = as_singleline(setup_base(*all.options, all));
+  if (c->batch_learn && !base_is_linear_gd(all))
+  {
+    c->batch_learn = false;
+    all.trace_message << "warning: --csoaa_batch_learn needs a plain gd base learner; turning it off." << std::endl;
+  }
+
+  learner<csoaa, example>& l =
+      init_learner(c, base, predict_or_learn<true>, predict_or_learn<false>, c->num_classes, prediction_type_t::multiclass);
   all.p->lp = cs_label;
   all.label_type = label_type_t::cs;
 
@@ -154,10 +243,20 @@ struct ldf
 
   bool rank;
   action_scores a_s;
-  uint64_t ft_offset;
+  uint64_t ft_offset;  // of the sequence being learned, predictions get theirs passed in
 
   v_array<action_scores> stored_preds;
 
+  // --ldf_factor_shared: namespaces whose features are identical in every action are scored once per decision.
+  bool factor_shared;
+  float shared_score;
+  std::vector<namespace_index> factored_namespaces;
+  std::vector<size_t> factored_sizes;
+
+  // reused across decisions to avoid allocating per call
+  multi_ex unlabeled;
+  std::vector<COST_SENSITIVE::wclass*> all_costs;
+
   ~ldf()
   {
     a_s.delete_v();
@@ -196,7 +295,7 @@ bool ec_seq_has_label_definition(multi_ex& ec_seq)
 
 inline bool cmp_wclass_ptr(const COST_SENSITIVE::wclass* a, const COST_SENSITIVE::wclass* b) { return a->x < b->x; }
 
-void compute_wap_values(std::vector<COST_SENSITIVE::wclass*> costs)
+void compute_wap_values(std::vector<COST_SENSITIVE::wclass*>& costs)
 {
   std::sort(costs.begin(), costs.end(), cmp_wclass_ptr);
   costs[0]->wap_value = 0.;
@@ -248,18 +347,88 @@ void unsubtract_example(example* ec)
   ec->indices.decr();
 }
 
-void make_single_prediction(ldf& data, single_learner& base, example& ec)
+template <class W>
+float linear_score(W& weights, const features& fs, uint64_t offset)
+{
+  float score = 0.f;
+  for (size_t j = 0; j < fs.size(); ++j) score += weights[fs.indicies[j] + offset] * fs.values[j];
+  return score;
+}
+
+// The shared feature merger lets every action view the same shared feature arrays. The linear part of such a
+// namespace scores the same for every action, so it is computed here once and the namespace is hidden from the
+// actions while they are predicted. make_single_prediction adds the shared score back as the label's initial value,
+// which gd includes in the raw prediction. Namespaces used by an interaction still go through the base learner.
+// Nothing is written unless a namespace is factored, so predictions that factor none can run on several threads.
+void factor_shared_namespaces(ldf& data, multi_ex& ec_seq, uint64_t ft_offset)
+{
+  vw& all = *data.all;
+  if (!data.factor_shared || ec_seq.size() < 2 || all.audit || all.hash_inv || all.sd->gravity != 0.)
+    return;
+
+  example& first = *ec_seq[0];
+  for (namespace_index ns : first.indices)
+  {
+    const features& fs = first.feature_space[ns];
+    if (!fs.nonempty() || (all.ignore_some_linear && all.ignore_linear[ns]))
+      continue;
+    bool shared = std::all_of(ec_seq.begin() + 1, ec_seq.end(), [ns, &fs](example* ec) {
+      const features& other = ec->feature_space[ns];
+      return other.values.begin() == fs.values.begin() && other.indicies.begin() == fs.indicies.begin() &&
+          other.size() == fs.size();
+    });
+    if (!shared)
+      continue;
+    bool interacts = std::any_of(first.interactions->begin(), first.interactions->end(),
+        [ns](const std::vector<namespace_index>& inter) {
+          return std::find(inter.begin(), inter.end(), ns) != inter.end();
+        });
+    if (interacts)
+      continue;
+
+    data.shared_score += all.weights.sparse ? linear_score(all.weights.sparse_weights, fs, ft_offset)
+                                            : linear_score(all.weights.dense_weights, fs, ft_offset);
+    data.factored_namespaces.push_back(ns);
+    data.factored_sizes.push_back(fs.size());
+  }
+
+  for (example* ec : ec_seq)
+    for (namespace_index ns : data.factored_namespaces)
+    {
+      features& fs = ec->feature_space[ns];
+      fs.values.end() = fs.values.begin();
+      fs.indicies.end() = fs.indicies.begin();
+    }
+}
+
+void unfactor_shared_namespaces(ldf& data, multi_ex& ec_seq)
+{
+  if (data.factored_namespaces.empty())
+    return;  // the shared score is still 0
+  for (example* ec : ec_seq)
+    for (size_t i = 0; i < data.factored_namespaces.size(); ++i)
+    {
+      features& fs = ec->feature_space[data.factored_namespaces[i]];
+      fs.values.end() = fs.values.begin() + data.factored_sizes[i];
+      fs.indicies.end() = fs.indicies.begin() + data.factored_sizes[i];
+    }
+  data.factored_namespaces.clear();
+  data.factored_sizes.clear();
+  data.shared_score = 0.f;
+}
+
+void make_single_prediction(ldf& data, single_learner& base, example& ec, uint64_t ft_offset)
 {
   COST_SENSITIVE::label ld = ec.l.cs;
   label_data simple_lbl;
-  simple_lbl.initial = 0.;
+  simple_lbl.initial = data.shared_score;
   simple_lbl.label = FLT_MAX;
 
   LabelDict::add_example_namespace_from_memory(data.label_features, ec, ld.costs[0].class_index);
 
   ec.l.simple = simple_lbl;
   uint64_t old_offset = ec.ft_offset;
-  ec.ft_offset = data.ft_offset;
+  ec.ft_offset = ft_offset;
   base.predict(ec);  // make a prediction
   ec.ft_offset = old_offset;
   ld.costs[0].partial_prediction = ec.partial_prediction;
@@ -292,7 +461,8 @@ bool test_ldf_sequence(ldf& data, multi_ex& ec_seq)
 void do_actual_learning_wap(ldf& data, single_learner& base, multi_ex& ec_seq)
 {
   size_t K = ec_seq.size();
-  std::vector<COST_SENSITIVE::wclass*> all_costs;
+  auto& all_costs = data.all_costs;
+  all_costs.clear();
   for (const auto& example : ec_seq) all_costs.push_back(&example->l.cs.costs[0]);
   compute_wap_values(all_costs);
 
@@ -427,9 +597,9 @@ void do_actual_learning_oaa(ldf& data, single_learner& base, multi_ex& ec_seq)
 
 /*
  * The begining of the multi_ex sequence may be labels.  Process those
- * and return the start index of the un-processed examples
+ * and return the un-processed examples (ec_seq_all itself if there were no labels)
  */
-multi_ex process_labels(ldf& data, const multi_ex& ec_seq_all);
+multi_ex& process_labels(ldf& data, multi_ex& ec_seq_all);
 
 /*
  * 1) process all labels at first
@@ -442,10 +612,13 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
   if (ec_seq_all.empty())
     return;  // nothing to do
 
-  data.ft_offset = ec_seq_all[0]->ft_offset;
+  // predictions write nothing to data, which lets --search_rollout_threads predict without a lock
+  const uint64_t ft_offset = ec_seq_all[0]->ft_offset;
+  if (is_learn)
+    data.ft_offset = ft_offset;
 
   // handle label definitions
-  auto ec_seq = process_labels(data, ec_seq_all);
+  auto& ec_seq = process_labels(data, ec_seq_all);
   if (ec_seq.empty())
     return;  // nothing more to do
 
@@ -463,6 +636,8 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
   bool isTest = test_ldf_sequence(data, ec_seq);
   /////////////////////// do prediction
   uint32_t predicted_K = 0;
+  factor_shared_namespaces(data, ec_seq, ft_offset);
+  auto unfactor_guard = VW::scope_exit([&data, &ec_seq] { unfactor_shared_namespaces(data, ec_seq); });
   if (data.rank)
   {
     data.a_s.clear();
@@ -471,7 +646,7 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
     {
       example* ec = ec_seq[k];
       data.stored_preds.push_back(ec->pred.a_s);
-      make_single_prediction(data, base, *ec);
+      make_single_prediction(data, base, *ec, ft_offset);
       action_score s;
       s.score = ec->partial_prediction;
       s.action = k;
@@ -486,7 +661,7 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
     for (uint32_t k = 0; k < K; k++)
     {
       example* ec = ec_seq[k];
-      make_single_prediction(data, base, *ec);
+      make_single_prediction(data, base, *ec, ft_offset);
       if (ec->partial_prediction < min_score)
       {
         min_score = ec->partial_prediction;
@@ -494,6 +669,7 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
       }
     }
   }
+  unfactor_guard.call();
 
   /////////////////////// learn
   if (is_learn && !isTest)
@@ -547,6 +723,55 @@ void do_actual_learning(ldf& data, single_learner& base, multi_ex& ec_seq_all)
   }
 }
 
+// Raw scores of every action under count models increment apart, computed with one pass over each action's features
+// when the models are as far apart as the ones of base.
+void multipredict(ldf& data, single_learner& base, multi_ex& ec_seq_all, size_t count, size_t increment,
+    polyprediction* pred, bool /* finalize_predictions */)
+{
+  if (ec_seq_all.empty() || count == 0)
+    return;
+
+  const uint64_t ft_offset = ec_seq_all[0]->ft_offset;
+  auto& ec_seq = process_labels(data, ec_seq_all);
+  if (ec_seq_has_label_definition(ec_seq))
+    THROW("error: label definition encountered in data block");
+
+  const size_t num_examples = ec_seq_all.size();
+  const size_t first = num_examples - ec_seq.size();  // label definitions come first and get no score
+  for (size_t c = 0; c < count; c++)
+    for (size_t k = 0; k < first; k++) pred[c * num_examples + k].scalar = 0.f;
+
+  static thread_local std::vector<polyprediction> model_preds;
+  model_preds.resize(count);
+  for (size_t k = first; k < num_examples; k++)
+  {
+    example& ec = *ec_seq_all[k];
+    COST_SENSITIVE::label ld = ec.l.cs;
+    LabelDict::add_example_namespace_from_memory(data.label_features, ec, ld.costs[0].class_index);
+    uint64_t old_offset = ec.ft_offset;
+
+    auto restore_guard = VW::scope_exit([&data, &ec, &ld, old_offset] {
+      ec.ft_offset = old_offset;
+      LabelDict::del_example_namespace_from_memory(data.label_features, ec, ld.costs[0].class_index);
+      ec.l.cs = ld;
+    });
+
+    ec.l.simple = {FLT_MAX, 0.f, 0.f};
+    ec.ft_offset = ft_offset;
+    if (increment == base.increment)
+      base.multipredict(ec, 0, count, model_preds.data(), false);
+    else
+      for (size_t c = 0; c < count; c++)
+      {
+        ec.ft_offset = ft_offset + static_cast<uint32_t>(c * increment);
+        base.predict(ec);
+        model_preds[c].scalar = ec.partial_prediction;
+      }
+    for (size_t c = 0; c < count; c++) pred[c * num_examples + k].scalar = model_preds[c].scalar;
+    ec.partial_prediction = model_preds[count - 1].scalar;
+  }
+}
+
 void global_print_newline(vw& all)
 {
   char temp[1];
@@ -773,7 +998,7 @@ void inline process_label(ldf& data, example* ec)
  * The begining of the multi_ex sequence may be labels.  Process those
  * and return the start index of the un-processed examples
  */
-multi_ex process_labels(ldf& data, const multi_ex& ec_seq_all)
+multi_ex& process_labels(ldf& data, multi_ex& ec_seq_all)
 {
   example* ec = ec_seq_all[0];
 
@@ -784,7 +1009,8 @@ multi_ex process_labels(ldf& data, const multi_ex& ec_seq_all)
   // process the first element as a label
   process_label(data, ec);
 
-  multi_ex ret;
+  multi_ex& ret = data.unlabeled;
+  ret.clear();
   size_t i = 1;
   // process the rest of the elements that are labels
   for (; i < ec_seq_all.size(); i++)
@@ -822,6 +1048,9 @@ base_learner* csldf_setup(options_i& options, vw& all)
   csldf_outer_options.add(make_option("csoaa_rank", ld->rank).keep().help("Return actions sorted by score order"));
   csldf_outer_options.add(
       make_option("probabilities", ld->is_probabilities).keep().help("predict probabilites of all classes"));
+  csldf_outer_options.add(make_option("ldf_factor_shared", ld->factor_shared)
+                              .help("Score linear features shared by all actions once per decision when predicting. "
+                                    "Needs a plain gd base learner."));
 
   option_group_definition csldf_inner_options("Cost Sensitive One Against All with Label Dependent Features");
   csldf_inner_options.add(make_option("wap_ldf", wap_ldf)
@@ -898,8 +1127,17 @@ base_learner* csldf_setup(options_i& options, vw& all)
     pred_type = prediction_type_t::multiclass;
 
   ld->read_example_this_loop = 0;
-  learner<ldf, multi_ex>& l = init_learner(ld, as_singleline(setup_base(*all.options, all)), do_actual_learning<true>,
-      do_actual_learning<false>, 1, pred_type);
+  single_learner* base = as_singleline(setup_base(*all.options, all));
+  // The shared score is a dot product with the weights of the shared features, which is only what the base predicts
+  // when it is gd under the identity scorer, with nothing in between adding features or changing the prediction.
+  if (ld->factor_shared && !base_is_linear_gd(all))
+  {
+    ld->factor_shared = false;
+    all.trace_message << "warning: --ldf_factor_shared needs a plain gd base learner; turning it off." << std::endl;
+  }
+  learner<ldf, multi_ex>& l =
+      init_learner(ld, base, do_actual_learning<true>, do_actual_learning<false>, 1, pred_type);
+  l.set_multipredict(multipredict);
   l.set_finish_example(finish_multiline_example);
   l.set_end_pass(end_pass);
   all.cost_sensitive = make_base(l);
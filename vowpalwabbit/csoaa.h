@@ -9,6 +9,9 @@ namespace CSOAA
 VW::LEARNER::base_learner* csoaa_setup(VW::config::options_i& options, vw& all);
 
 VW::LEARNER::base_learner* csldf_setup(VW::config::options_i& options, vw& all);
+
+// Can several threads predict at once with the learners set up so far, as long as none of them learns?
+bool predict_is_thread_safe(vw& all);
 struct csoaa;
 void finish_example(vw& all, csoaa&, example& ec);
 }  // namespace CSOAA
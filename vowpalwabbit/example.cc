@@ -273,6 +273,22 @@ void vec_ffs_store(full_features_and_source& p, float fx, uint64_t fi)
   p.fs.push_back(fx, (uint64_t)(fi >> p.stride_shift) & p.mask);
 }
 
+// Replaces the contents of fs with all the features of ec, interactions included, keeping its storage.
+static void flatten_features(vw& all, example* ec, features& fs)
+{
+  full_features_and_source ffs;
+  std::swap(ffs.fs, fs);
+  ffs.fs.clear();
+  ffs.stride_shift = all.weights.stride_shift();
+  if (all.weights.not_null())  // TODO:temporary fix. all.weights is not initialized at this point in some cases.
+    ffs.mask = (uint64_t)all.weights.mask() >> all.weights.stride_shift();
+  else
+    ffs.mask = (uint64_t)LONG_MAX >> all.weights.stride_shift();
+  GD::foreach_feature<full_features_and_source, uint64_t, vec_ffs_store>(all, *ec, ffs);
+
+  std::swap(fs, ffs.fs);
+}
+
 flat_example* flatten_example(vw& all, example* ec)
 {
   flat_example& fec = calloc_or_throw<flat_example>();
@@ -290,15 +306,7 @@ flat_example* flatten_example(vw& all, example* ec)
   fec.ft_offset = ec->ft_offset;
   fec.num_features = ec->num_features;
 
-  full_features_and_source ffs;
-  ffs.stride_shift = all.weights.stride_shift();
-  if (all.weights.not_null())  // TODO:temporary fix. all.weights is not initialized at this point in some cases.
-    ffs.mask = (uint64_t)all.weights.mask() >> all.weights.stride_shift();
-  else
-    ffs.mask = (uint64_t)LONG_MAX >> all.weights.stride_shift();
-  GD::foreach_feature<full_features_and_source, uint64_t, vec_ffs_store>(all, *ec, ffs);
-
-  std::swap(fec.fs, ffs.fs);
+  flatten_features(all, ec, fec.fs);
 
   return &fec;
 }
@@ -311,6 +319,15 @@ flat_example* flatten_sort_example(vw& all, example* ec)
   return fec;
 }
 
+float flatten_sort_features(vw& all, example* ec, features& fs)
+{
+  flatten_features(all, ec, fs);
+  if (fs.size() == 0)
+    return 0.f;
+  fs.sort(all.parse_mask);
+  return collision_cleanup(fs);
+}
+
 void free_flatten_example(flat_example* fec)
 {
   // note: The label memory should be freed by by freeing the original example.
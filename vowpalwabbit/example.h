@@ -123,6 +123,8 @@ struct flat_example
 
 flat_example* flatten_example(vw& all, example* ec);
 flat_example* flatten_sort_example(vw& all, example* ec);
+// Flattens and sorts ec into fs like flatten_sort_example, reusing the storage of fs. Returns the sum of squares.
+float flatten_sort_features(vw& all, example* ec, features& fs);
 void free_flatten_example(flat_example* fec);
 
 inline int example_is_newline(example const& ec)
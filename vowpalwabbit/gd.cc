@@ -51,6 +51,9 @@ struct gd
   bool adaptive_input;
   bool normalized_input;
   bool adax;
+  bool allreduce_async;
+  float allreduce_mix;
+  async_avg_state async_avg;
 
   vw* all;  // parallel, features, parameters
 };
@@ -156,7 +159,10 @@ void end_pass(gd& g)
   }
   else
     sync_weights(all);
-  if (all.all_reduce != nullptr)
+  if (all.all_reduce != nullptr && g.allreduce_async)
+    // merge the average started at the end of the previous pass; the next one is started below
+    accumulate_avg_async_finish(all, all.weights, g.async_avg, g.allreduce_mix);
+  else if (all.all_reduce != nullptr)
   {
     if (all.weights.adaptive)
       accumulate_weighted_avg(all, all.weights);
@@ -175,6 +181,15 @@ void end_pass(gd& g)
         ((all.check_holdout_every_n_passes <= 1) || ((all.current_pass % all.check_holdout_every_n_passes) == 0)))
       set_done(all);
   }
+
+  if (all.all_reduce != nullptr && g.allreduce_async)
+    accumulate_avg_async_start(all, all.weights, g.async_avg);
+}
+
+void end_examples(gd& g)
+{
+  if (g.all->all_reduce != nullptr && g.allreduce_async)
+    accumulate_avg_async_finish(*g.all, g.all->weights, g.async_avg, g.allreduce_mix);
 }
 
 #include <algorithm>
@@ -407,13 +422,20 @@ void multipredict(
     else
       foreach_feature<multipredict_info<sparse_parameters>, uint64_t, vec_add_multipredict>(all, ec, mp);
   }
-  else
+  else if (l1)
   {
     multipredict_info<dense_parameters> mp = {count, step, pred, g.all->weights.dense_weights, (float)all.sd->gravity};
-    if (l1)
-      foreach_feature<multipredict_info<dense_parameters>, uint64_t, vec_add_trunc_multipredict>(all, ec, mp);
-    else
-      foreach_feature<multipredict_info<dense_parameters>, uint64_t, vec_add_multipredict>(all, ec, mp);
+    foreach_feature<multipredict_info<dense_parameters>, uint64_t, vec_add_trunc_multipredict>(all, ec, mp);
+  }
+  else
+  {
+    // per thread, so that --search_rollout_threads can predict without a lock
+    static thread_local std::vector<float> scores;
+    scores.assign(count, ec.l.simple.initial);
+    dense_multipredict_info mp = {
+        count, step, scores.data(), all.weights.dense_weights.first(), all.weights.dense_weights.mask()};
+    foreach_feature<dense_multipredict_info, uint64_t, vec_add_dense_multipredict>(all, ec, mp);
+    for (size_t c = 0; c < count; c++) pred[c].scalar = scores[c];
   }
   if (all.sd->contraction != 1.)
     for (size_t c = 0; c < count; c++) pred[c].scalar *= (float)all.sd->contraction;
@@ -1130,9 +1152,22 @@ base_learner* setup(options_i& options, vw& all)
       .add(make_option("l2_state", all.sd->contraction)
                .keep(all.save_resume)
                .default_value(1.)
-               .help("use per feature normalized updates"));
+               .help("use per feature normalized updates"))
+      .add(make_option("allreduce_async", g->allreduce_async)
+               .help("average weights across nodes in the background while the next pass is learned"))
+      .add(make_option("allreduce_mix", g->allreduce_mix)
+               .default_value(1.f)
+               .help("fraction of the background average (relative to the weights it was started from) merged back "
+                     "into the local weights"));
   options.add_and_parse(new_options);
 
+  if (options.was_supplied("allreduce_mix") && !g->allreduce_async)
+    THROW("--allreduce_mix requires --allreduce_async");
+  if (g->allreduce_mix < 0.f || g->allreduce_mix > 1.f)
+    THROW("--allreduce_mix must be in [0, 1]");
+  if (g->allreduce_async && !options.was_supplied("span_server") && !options.was_supplied("shm_nodes_per_host"))
+    THROW("--allreduce_async requires --span_server or --shm_nodes_per_host");
+
   g->all = &all;
   g->all->normalized_sum_norm_x = 0;
   g->no_win_counter = 0;
@@ -1241,6 +1276,7 @@ base_learner* setup(options_i& options, vw& all)
   ret.set_update(bare->update);
   ret.set_save_load(save_load);
   ret.set_end_pass(end_pass);
+  ret.set_end_examples(end_examples);
   return make_base(ret);
 }
 
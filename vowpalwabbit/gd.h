@@ -57,6 +57,37 @@ inline void vec_add_multipredict(multipredict_info<T>& mp, const float fx, uint6
     }
 }
 
+// Multipredict over dense weights. The scores live in one contiguous buffer and the weights of the count models are
+// read with a single strided walk, so the inner loop over the models vectorizes.
+struct dense_multipredict_info
+{
+  size_t count;
+  size_t step;
+  float* scores;
+  const weight* weights;
+  uint64_t mask;
+};
+
+inline void vec_add_dense_multipredict(dense_multipredict_info& mp, const float fx, uint64_t fi)
+{
+  if ((-1e-10 < fx) && (fx < 1e-10))
+    return;
+  const size_t count = mp.count;
+  const size_t step = mp.step;
+  float* scores = mp.scores;
+  fi &= mp.mask;
+  if (fi + (uint64_t)((count - 1) * step) <= mp.mask)
+  {
+    const weight* w = mp.weights + fi;
+    if (step == 1)
+      for (size_t c = 0; c < count; ++c) scores[c] += fx * w[c];
+    else
+      for (size_t c = 0; c < count; ++c) scores[c] += fx * w[c * step];
+  }
+  else
+    for (size_t c = 0; c < count; ++c, fi += (uint64_t)step) scores[c] += fx * mp.weights[fi & mp.mask];
+}
+
 // iterate through one namespace (or its part), callback function T(some_data_R, feature_value_x, feature_weight)
 template <class R, typename T>
 inline void foreach_feature(vw& all, features& fs, R& dat, uint64_t offset = 0, float mult = 1.)
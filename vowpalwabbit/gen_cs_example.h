@@ -246,9 +246,10 @@ void gen_cs_example(cb_to_cs_adf& c, multi_ex& ec_seq, COST_SENSITIVE::label& cs
   }
 }
 
-template <bool is_learn>
-void call_cs_ldf(VW::LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::label>& cb_labels,
-    COST_SENSITIVE::label& cs_labels, v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset, size_t id = 0)
+// 1st: save cb_label (into mydata) and store cs_label for each example, which will be passed into base.learn.
+// also save offsets
+inline uint64_t prepare_cs_ldf(multi_ex& examples, v_array<CB::label>& cb_labels, COST_SENSITIVE::label& cs_labels,
+    v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset)
 {
   cb_labels.clear();
   if (prepped_cs_labels.size() < cs_labels.costs.size() + 1)
@@ -257,8 +258,6 @@ void call_cs_ldf(VW::LEARNER::multi_learner& base, multi_ex& examples, v_array<C
     prepped_cs_labels.end() = prepped_cs_labels.end_array;
   }
 
-  // 1st: save cb_label (into mydata) and store cs_label for each example, which will be passed into base.learn.
-  // also save offsets
   uint64_t saved_offset = examples[0]->ft_offset;
   size_t index = 0;
   for (auto ec : examples)
@@ -269,20 +268,30 @@ void call_cs_ldf(VW::LEARNER::multi_learner& base, multi_ex& examples, v_array<C
     ec->l.cs = prepped_cs_labels[index++];
     ec->ft_offset = offset;
   }
+  return saved_offset;
+}
+
+// 3rd: restore cb_label for each example
+// (**ec).l.cb = array.element.
+// and restore offsets
+inline void restore_cb_labels(multi_ex& examples, v_array<CB::label>& cb_labels, uint64_t saved_offset)
+{
+  for (size_t i = 0; i < examples.size(); ++i)
+  {
+    examples[i]->l.cb = cb_labels[i];
+    examples[i]->ft_offset = saved_offset;
+  }
+}
+
+template <bool is_learn>
+void call_cs_ldf(VW::LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::label>& cb_labels,
+    COST_SENSITIVE::label& cs_labels, v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset, size_t id = 0)
+{
+  uint64_t saved_offset = prepare_cs_ldf(examples, cb_labels, cs_labels, prepped_cs_labels, offset);
 
   // Guard example state restore against throws
-  auto restore_guard = VW::scope_exit(
-    [&cb_labels, saved_offset, &examples]
-    {
-      // 3rd: restore cb_label for each example
-      // (**ec).l.cb = array.element.
-      // and restore offsets
-      for (size_t i = 0; i < examples.size(); ++i)
-      {
-        examples[i]->l.cb = cb_labels[i];
-        examples[i]->ft_offset = saved_offset;
-      }
-    });
+  auto restore_guard =
+      VW::scope_exit([&cb_labels, saved_offset, &examples] { restore_cb_labels(examples, cb_labels, saved_offset); });
 
   // 2nd: predict for each ex
   // // call base.predict for all examples
@@ -291,4 +300,31 @@ void call_cs_ldf(VW::LEARNER::multi_learner& base, multi_ex& examples, v_array<C
   else
     base.predict(examples, (int32_t)id);
 }
+
+// Scores the examples under count models increment apart, the offsets learn(examples, c) would use for model c.
+// When the models are as far apart as the ones of base this is one call to base.multipredict, otherwise (several
+// weight vectors per model, e.g. --cb_type dr) every model is scored on its own into scratch.
+inline void multipredict_cs_ldf(VW::LEARNER::multi_learner& base, multi_ex& examples, v_array<CB::label>& cb_labels,
+    COST_SENSITIVE::label& cs_labels, v_array<COST_SENSITIVE::label>& prepped_cs_labels, uint64_t offset, size_t count,
+    size_t increment, polyprediction* pred, std::vector<polyprediction>& scratch)
+{
+  uint64_t saved_offset = prepare_cs_ldf(examples, cb_labels, cs_labels, prepped_cs_labels, offset);
+  auto restore_guard =
+      VW::scope_exit([&cb_labels, saved_offset, &examples] { restore_cb_labels(examples, cb_labels, saved_offset); });
+  if (increment == base.increment)
+  {
+    base.multipredict(examples, 0, count, pred, false);
+    return;
+  }
+
+  const size_t num_examples = examples.size();
+  scratch.resize(num_examples);
+  for (size_t c = 0; c < count; c++)
+  {
+    VW::LEARNER::increment_offset(examples, increment, c);
+    base.multipredict(examples, 0, 1, scratch.data(), false);
+    VW::LEARNER::decrement_offset(examples, increment, c);
+    for (size_t k = 0; k < num_examples; k++) pred[c * num_examples + k].scalar = scratch[k].scalar;
+  }
+}
 }  // namespace GEN_CS
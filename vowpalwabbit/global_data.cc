@@ -47,12 +47,14 @@ size_t really_read(VW::io::reader* sock, void* in, size_t count)
   return done;
 }
 
-void get_prediction(VW::io::reader* f, float& res, float& weight)
+bool get_prediction(VW::io::reader* f, float& res, float& weight)
 {
   global_prediction p;
-  really_read(f, &p, sizeof(p));
+  if (really_read(f, &p, sizeof(p)) < sizeof(p))
+    return false;
   res = p.p;
   weight = p.weight;
+  return true;
 }
 
 void send_prediction(VW::io::writer* f, global_prediction p)
@@ -152,9 +154,10 @@ void print_raw_text_by_ref(VW::io::writer* f, const std::string& s, const v_arra
 
 void set_mm(shared_data* sd, float label)
 {
+  if (label == FLT_MAX)
+    return;  // no label, which also keeps predictions from writing to sd
   sd->min_label = std::min(sd->min_label, label);
-  if (label != FLT_MAX)
-    sd->max_label = std::max(sd->max_label, label);
+  sd->max_label = std::max(sd->max_label, label);
 }
 
 void noop_mm(shared_data*, float) {}
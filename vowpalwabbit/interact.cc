@@ -177,6 +177,7 @@ VW::LEARNER::base_learner* interact_setup(options_i& options, vw& all)
   VW::LEARNER::learner<interact, example>* l;
   l = &VW::LEARNER::init_learner(
       data, as_singleline(setup_base(options, all)), predict_or_learn<true, true>, predict_or_learn<false, true>, 1);
+  l->set_writes_features();
 
   return make_base(*l);
 }
@@ -7,7 +7,11 @@
 #include <cstring>
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include "parse_example.h"
 #include "constant.h"
@@ -21,6 +25,7 @@
 #include "vw_allreduce.h"
 #include "rand48.h"
 #include "reductions.h"
+#include "sparse_dot.h"
 
 #define SVM_KER_LIN 0
 #define SVM_KER_RBF 1
@@ -36,9 +41,14 @@ struct svm_params;
 static size_t num_kernel_evals = 0;
 static size_t num_cache_evals = 0;
 
+// Kernel values are cached in rows indexed by the stable id of each support vector, not by its position in the
+// model, so reordering or removing support vectors does not move any cached value. Missing entries hold NaN.
 struct svm_example
 {
   v_array<float> krow;
+  size_t cached;     // number of kernel values held in krow
+  size_t last_used;  // when krow was last read, rows used least recently are dropped first by trim_cache
+  size_t id;         // slot of this example in the rows of the others, once it is a support vector
   flat_example ex;
 
   ~svm_example();
@@ -53,6 +63,10 @@ struct svm_model
   v_array<svm_example*> support_vec;
   v_array<float> alpha;
   v_array<float> delta;
+
+  size_t num_ids;             // ids handed out so far, rows are never longer than this
+  v_array<size_t> free_ids;   // ids of removed support vectors, ready to be reused
+  v_array<size_t> freed_ids;  // removed during the current pool, see release_ids
 };
 
 void free_svm_model(svm_model* model)
@@ -76,6 +90,8 @@ void free_svm_model(svm_model* model)
   model->support_vec.delete_v();
   model->alpha.delete_v();
   model->delta.delete_v();
+  model->free_ids.delete_v();
+  model->freed_ids.delete_v();
   free(model);
 }
 
@@ -93,8 +109,8 @@ struct svm_params
   size_t reprocess;
 
   svm_model* model;
-  size_t maxcache;
-  // size_t curcache;
+  size_t maxcache;  // budget of cached kernel values over all support vectors
+  size_t cache_clock;
 
   svm_example** pool;
   float lambda;
@@ -157,29 +173,42 @@ svm_example::~svm_example()
 
 float kernel_function(const flat_example* fec1, const flat_example* fec2, void* params, size_t kernel_type);
 
+static inline bool is_cached(float kv) { return !std::isnan(kv); }
+
+static void grow_row(v_array<float>& krow, size_t num_ids)
+{
+  while (krow.size() < num_ids) krow.push_back(std::numeric_limits<float>::quiet_NaN());
+}
+
 int svm_example::compute_kernels(svm_params& params)
 {
   int alloc = 0;
   svm_model* model = params.model;
   size_t n = model->num_support;
+  last_used = ++params.cache_clock;
 
-  if (krow.size() < n)
+  // every entry is checked rather than trusting cached, which also counts values that are not in use right now
+  grow_row(krow, model->num_ids);
+  size_t hits = 0;
+  for (size_t i = 0; i < n; i++)
   {
+    svm_example* sec = model->support_vec[i];
+    float& kv = krow[sec->id];
+    if (is_cached(kv))
+    {
+      hits++;
+      continue;
+    }
     // computing new kernel values and caching them
-    // if(params->curcache + n > params->maxcache)
-    // trim_cache(params);
-    num_kernel_evals += krow.size();
-    // std::cerr<<"Kernels ";
-    for (size_t i = krow.size(); i < n; i++)
+    kv = kernel_function(&ex, &(sec->ex), params.kernel_params, params.kernel_type);
+    if (is_cached(kv))
     {
-      svm_example* sec = model->support_vec[i];
-      float kv = kernel_function(&ex, &(sec->ex), params.kernel_params, params.kernel_type);
-      krow.push_back(kv);
+      cached++;
       alloc += 1;
-      // std::cerr<<kv<<" ";
     }
-    // std::cerr<< endl;
   }
+  if (hits < n)
+    num_kernel_evals += hits;
   else
     num_cache_evals += n;
   return alloc;
@@ -187,12 +216,28 @@ int svm_example::compute_kernels(svm_params& params)
 
 int svm_example::clear_kernels()
 {
-  int rowsize = (int)krow.size();
-  krow.end() = krow.begin();
-  krow.resize(0);
+  int rowsize = (int)cached;
+  krow.clear();
+  cached = 0;
   return -rowsize;
 }
 
+// Kernel value between ec and the support vector at position pos, ec->compute_kernels must have been called.
+static inline float cached_kernel(const svm_model* model, const svm_example* ec, size_t pos)
+{
+  return ec->krow[model->support_vec[pos]->id];
+}
+
+// Sum over the support vectors of K(ec, sv_i) * alpha_i, ec->compute_kernels must have been called.
+static float kernel_dot(const svm_model* model, const svm_example* ec)
+{
+  float dot_prod = 0.;
+  for (size_t i = 0; i < model->num_support; i++) dot_prod += cached_kernel(model, ec, i) * model->alpha[i];
+  return dot_prod;
+}
+
+// Moves the support vector at svi to the front and makes its kernel values available in every row, copying them
+// from its own row instead of evaluating the kernel again.
 static int make_hot_sv(svm_params& params, size_t svi)
 {
   svm_model* model = params.model;
@@ -213,41 +258,47 @@ static int make_hot_sv(svm_params& params, size_t svi)
   model->support_vec[0] = svi_e;
   model->alpha[0] = svi_alpha;
   model->delta[0] = svi_delta;
-  // rotate cache
+  // share the row of svi, the kernel is symmetric
   for (size_t j = 0; j < n; j++)
   {
     svm_example* e = model->support_vec[j];
-    size_t rowsize = e->krow.size();
-    if (svi < rowsize)
+    grow_row(e->krow, model->num_ids);
+    float& kv = e->krow[svi_e->id];
+    if (!is_cached(kv))
     {
-      float kv = e->krow[svi];
-      for (size_t i = svi; i > 0; --i) e->krow[i] = e->krow[i - 1];
-      e->krow[0] = kv;
-    }
-    else
-    {
-      float kv = svi_e->krow[j];
-      e->krow.push_back(0);
-      alloc += 1;
-      for (size_t i = e->krow.size() - 1; i > 0; --i) e->krow[i] = e->krow[i - 1];
-      e->krow[0] = kv;
+      kv = svi_e->krow[e->id];
+      if (is_cached(kv))
+      {
+        e->cached++;
+        alloc += 1;
+      }
     }
   }
   return alloc;
 }
 
+// Drops the rows of the least recently used support vectors until at most params.maxcache kernel values are cached.
 static int trim_cache(svm_params& params)
 {
-  int sz = (int)params.maxcache;
   svm_model* model = params.model;
   size_t n = model->num_support;
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += model->support_vec[i]->cached;
+  if (total <= params.maxcache)
+    return 0;
+
+  // a heap on last_used only orders the rows that are actually dropped
+  auto more_recent = [](const svm_example* a, const svm_example* b) { return a->last_used > b->last_used; };
+  std::vector<svm_example*> rows(model->support_vec.begin(), model->support_vec.end());
+  std::make_heap(rows.begin(), rows.end(), more_recent);
   int alloc = 0;
-  for (size_t i = 0; i < n; i++)
+  while (total > params.maxcache && !rows.empty())
   {
-    svm_example* e = model->support_vec[i];
-    sz -= (int)e->krow.size();
-    if (sz < 0)
-      alloc += e->clear_kernels();
+    std::pop_heap(rows.begin(), rows.end(), more_recent);
+    svm_example* e = rows.back();
+    rows.pop_back();
+    total -= e->cached;
+    alloc += e->clear_kernels();
   }
   return alloc;
 }
@@ -348,6 +399,7 @@ void save_load_svm_model(svm_params& params, io_buf& model_file, bool read, bool
       save_load_flat_example(model_file, read, fec);
       svm_example* tmp = &calloc_or_throw<svm_example>();
       tmp->init_svm_example(fec);
+      tmp->id = i;
       model->support_vec.push_back(tmp);
     }
     else
@@ -357,6 +409,9 @@ void save_load_svm_model(svm_params& params, io_buf& model_file, bool read, bool
     }
   }
 
+  if (read)
+    model->num_ids = model->num_support;
+
   if (read)
     model->alpha.resize(model->num_support);
   bin_text_read_write_fixed(
@@ -380,36 +435,10 @@ void save_load(svm_params& params, io_buf& model_file, bool read, bool text)
 
 float linear_kernel(const flat_example* fec1, const flat_example* fec2)
 {
-  float dotprod = 0;
-
-  features& fs_1 = (features&)fec1->fs;
-  features& fs_2 = (features&)fec2->fs;
-  if (fs_2.indicies.size() == 0)
-    return 0.f;
-
-  int numint = 0;
-  for (size_t idx1 = 0, idx2 = 0; idx1 < fs_1.size() && idx2 < fs_2.size(); idx1++)
-  {
-    uint64_t ec1pos = fs_1.indicies[idx1];
-    uint64_t ec2pos = fs_2.indicies[idx2];
-    // params.all->opts_n_args.trace_message<<ec1pos<<" "<<ec2pos<<" "<<idx1<<" "<<idx2<<" "<<f->x<<" "<<ec2f->x<< endl;
-    if (ec1pos < ec2pos)
-      continue;
-
-    while (ec1pos > ec2pos && ++idx2 < fs_2.size()) ec2pos = fs_2.indicies[idx2];
-
-    if (ec1pos == ec2pos)
-    {
-      // params.all->opts_n_args.trace_message<<ec1pos<<" "<<ec2pos<<" "<<idx1<<" "<<idx2<<" "<<f->x<<"
-      // "<<ec2f->x<< endl;
-      numint++;
-      dotprod += fs_1.values[idx1] * fs_2.values[idx2];
-      ++idx2;
-    }
-  }
-  // params.all->opts_n_args.trace_message<< endl;
-  // params.all->opts_n_args.trace_message<<"numint = "<<numint<<" dotprod = "<<dotprod<< endl;
-  return dotprod;
+  const features& fs_1 = fec1->fs;
+  const features& fs_2 = fec2->fs;
+  return VW::sparse_dot(
+      fs_1.indicies.begin(), fs_1.values.begin(), fs_1.size(), fs_2.indicies.begin(), fs_2.values.begin(), fs_2.size());
 }
 
 float poly_kernel(const flat_example* fec1, const flat_example* fec2, int power)
@@ -441,22 +470,14 @@ float kernel_function(const flat_example* fec1, const flat_example* fec2, void*
   return 0;
 }
 
-float dense_dot(float* v1, const v_array<float>& v2, size_t n)
-{
-  float dot_prod = 0.;
-  for (size_t i = 0; i < n; i++) dot_prod += v1[i] * v2[i];
-  return dot_prod;
-}
-
 void predict(svm_params& params, svm_example** ec_arr, float* scores, size_t n)
 {
   svm_model* model = params.model;
   for (size_t i = 0; i < n; i++)
   {
     ec_arr[i]->compute_kernels(params);
-    // std::cout<<"size of krow = "<<ec_arr[i]->krow.size()<< endl;
-    if (ec_arr[i]->krow.size() > 0)
-      scores[i] = dense_dot(ec_arr[i]->krow.begin(), model->alpha, model->num_support) / params.lambda;
+    if (model->num_support > 0)
+      scores[i] = kernel_dot(model, ec_arr[i]) / params.lambda;
     else
       scores[i] = 0;
   }
@@ -509,6 +530,7 @@ int remove(svm_params& params, size_t svi)
     params.all->trace_message << "Internal error at " << __FILE__ << ":" << __LINE__ << endl;
   // shift params fields
   svm_example* svi_e = model->support_vec[svi];
+  size_t id = svi_e->id;
   for (size_t i = svi; i < model->num_support - 1; ++i)
   {
     model->support_vec[i] = model->support_vec[i + 1];
@@ -521,26 +543,42 @@ int remove(svm_params& params, size_t svi)
   model->alpha.pop();
   model->delta.pop();
   model->num_support--;
-  // shift cache
+  // drop the cached values of svi, its id is reused by a later support vector
   int alloc = 0;
   for (size_t j = 0; j < model->num_support; j++)
   {
     svm_example* e = model->support_vec[j];
-    size_t rowsize = e->krow.size();
-    if (svi < rowsize)
+    if (id < e->krow.size() && is_cached(e->krow[id]))
     {
-      for (size_t i = svi; i < rowsize - 1; i++) e->krow[i] = e->krow[i + 1];
-      e->krow.pop();
+      e->krow[id] = std::numeric_limits<float>::quiet_NaN();
+      e->cached--;
       alloc -= 1;
     }
   }
+  model->freed_ids.push_back(id);
   return alloc;
 }
 
+// Makes the ids removed while training on the pool available again. Pool examples which did not become support
+// vectors can still hold values for them, so they are only reused once the pool is done.
+void release_ids(svm_model* model)
+{
+  for (size_t id : model->freed_ids) model->free_ids.push_back(id);
+  model->freed_ids.clear();
+}
+
 int add(svm_params& params, svm_example* fec)
 {
   svm_model* model = params.model;
   model->num_support++;
+  fec->id = model->free_ids.empty() ? model->num_ids++ : model->free_ids.pop();
+  // a pool example can hold values for support vectors removed since it was scored, their ids are reused later
+  for (size_t id : model->freed_ids)
+    if (id < fec->krow.size() && is_cached(fec->krow[id]))
+    {
+      fec->krow[id] = std::numeric_limits<float>::quiet_NaN();
+      fec->cached--;
+    }
   model->support_vec.push_back(fec);
   model->alpha.push_back(0.);
   model->delta.push_back(0.);
@@ -557,15 +595,15 @@ bool update(svm_params& params, size_t pos)
   svm_example* fec = model->support_vec[pos];
   label_data& ld = fec->ex.l.simple;
   fec->compute_kernels(params);
-  float* inprods = fec->krow.begin();
-  float alphaKi = dense_dot(inprods, model->alpha, model->num_support);
+  float alphaKi = kernel_dot(model, fec);
   model->delta[pos] = alphaKi * ld.label / params.lambda - 1;
   float alpha_old = model->alpha[pos];
-  alphaKi -= model->alpha[pos] * inprods[pos];
+  float kii = cached_kernel(model, fec, pos);
+  alphaKi -= model->alpha[pos] * kii;
   model->alpha[pos] = 0.;
 
   float proj = alphaKi * ld.label;
-  float ai = (params.lambda - proj) / inprods[pos];
+  float ai = (params.lambda - proj) / kii;
   // std::cout<<model->num_support<<" "<<pos<<" "<<proj<<" "<<alphaKi<<" "<<alpha_old<<" "<<ld.label<<"
   // "<<model->delta[pos]<<" " << ai<<" "<<params.lambda<< endl;
 
@@ -590,7 +628,7 @@ bool update(svm_params& params, size_t pos)
   for (size_t i = 0; i < model->num_support; i++)
   {
     label_data& ldi = model->support_vec[i]->ex.l.simple;
-    model->delta[i] += diff * inprods[i] * ldi.label / params.lambda;
+    model->delta[i] += diff * cached_kernel(model, fec, i) * ldi.label / params.lambda;
   }
 
   if (fabs(ai) <= 1.0e-10)
@@ -809,6 +847,7 @@ void train(svm_params& params)
         free(subopt);
       }
     }
+    release_ids(model);
   }
   else
     for (size_t i = 0; i < params.pool_pos; i++) delete params.pool[i];
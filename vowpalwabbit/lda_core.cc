@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <thread>
 #include "correctedMath.h"
 #include "vw_versions.h"
 #include "vw.h"
@@ -50,6 +51,14 @@ class index_feature
   bool operator<(const index_feature b) const { return f.weight_index < b.f.weight_index; }
 };
 
+// Scratch space for the variational inference of one document, one per E-step thread.
+struct lda_inference_scratch
+{
+  v_array<float> new_gamma;
+  v_array<float> old_gamma;
+  v_array<float> Elogtheta;
+};
+
 struct lda
 {
   size_t topics;
@@ -62,7 +71,6 @@ struct lda
 
   size_t finish_example_count;
 
-  v_array<float> Elogtheta;
   v_array<float> decay_levels;
   v_array<float> total_new;
   v_array<example *> examples;
@@ -72,12 +80,20 @@ struct lda
   v_array<float> v;
   std::vector<index_feature> sorted_features;
 
+  // E-step threads, with their scratch space and the per document scores they produce.
+  size_t threads;
+  std::vector<lda_inference_scratch> inference_scratch;
+  std::vector<float> doc_scores;
+
   bool compute_coherence_metrics;
 
   // size by 1 << bits
   std::vector<uint32_t> feature_counts;
   std::vector<std::vector<size_t>> feature_to_example_map;
 
+  // Whether total_lambda holds the per topic sums of the weights. It is set up when the weights are initialized or
+  // loaded and then kept up to date by the M-step, so the weight table only has to be swept for models saved
+  // without it.
   bool total_lambda_init;
 
   double example_t;
@@ -92,7 +108,12 @@ struct lda
 
   ~lda()
   {
-    Elogtheta.delete_v();
+    for (auto &scratch : inference_scratch)
+    {
+      scratch.new_gamma.delete_v();
+      scratch.old_gamma.delete_v();
+      scratch.Elogtheta.delete_v();
+    }
     decay_levels.delete_v();
     total_new.delete_v();
     examples.delete_v();
@@ -294,7 +315,9 @@ inline v4sf vfastdigamma(v4sf x)
       logterm;
 }
 
-void vexpdigammify(vw &all, float *gamma, const float underflow_threshold)
+// Sum of gamma[0, lda) as vexpdigammify adds it up: the unaligned head and the tail one at a time, the aligned middle
+// in four lanes that are combined last. The AVX2 kernel uses it as well so both paths normalize by the same value.
+float vsum_topics(vw &all, float *gamma)
 {
   float extra_sum = 0.0f;
   v4sf sum = v4sfl(0.0f);
@@ -303,26 +326,12 @@ void vexpdigammify(vw &all, float *gamma, const float underflow_threshold)
 
   // Iterate through the initial part of the array that isn't 128-bit SIMD
   // aligned.
-  for (fp = gamma; fp < fpend && !is_aligned16(fp); ++fp)
-  {
-    extra_sum += *fp;
-    *fp = fastdigamma(*fp);
-  }
+  for (fp = gamma; fp < fpend && !is_aligned16(fp); ++fp) extra_sum += *fp;
 
   // Rip through the aligned portion...
-  for (; is_aligned16(fp) && fp + 4 < fpend; fp += 4)
-  {
-    v4sf arg = _mm_load_ps(fp);
-    sum = sum + arg;
-    arg = vfastdigamma(arg);
-    _mm_store_ps(fp, arg);
-  }
+  for (; is_aligned16(fp) && fp + 4 < fpend; fp += 4) sum = sum + _mm_load_ps(fp);
 
-  for (; fp < fpend; ++fp)
-  {
-    extra_sum += *fp;
-    *fp = fastdigamma(*fp);
-  }
+  for (; fp < fpend; ++fp) extra_sum += *fp;
 
 #if defined(__SSE3__) || defined(__SSE4_1__)
   // Do two horizontal adds on sum, extract the total from the 0 element:
@@ -332,6 +341,21 @@ void vexpdigammify(vw &all, float *gamma, const float underflow_threshold)
 #else
   extra_sum += v4sf_index<0>(sum) + v4sf_index<1>(sum) + v4sf_index<2>(sum) + v4sf_index<3>(sum);
 #endif
+  return extra_sum;
+}
+
+void vexpdigammify(vw &all, float *gamma, const float underflow_threshold)
+{
+  float extra_sum = vsum_topics(all, gamma);
+  v4sf sum;
+  float *fp;
+  const float *fpend = gamma + all.lda;
+
+  for (fp = gamma; fp < fpend && !is_aligned16(fp); ++fp) *fp = fastdigamma(*fp);
+
+  for (; is_aligned16(fp) && fp + 4 < fpend; fp += 4) _mm_store_ps(fp, vfastdigamma(_mm_load_ps(fp)));
+
+  for (; fp < fpend; ++fp) *fp = fastdigamma(*fp);
 
   extra_sum = fastdigamma(extra_sum);
   sum = v4sfl(extra_sum);
@@ -379,6 +403,25 @@ void vexpdigammify_2(vw &all, float *gamma, const float *norm, const float under
   for (; fp < fpend; ++fp, ++np) *fp = fmax(underflow_threshold, fastexp(fastdigamma(*fp) - *np));
 }
 
+// Dot product with eight partial sums, kept in two registers of four lanes. The partial sums are combined in the
+// order vdot_avx2 uses, so the SIMD math mode gives the same result with and without AVX2.
+float vdot(const float *a, const float *b, size_t n)
+{
+  v4sf lo = v4sfl(0.0f);
+  v4sf hi = v4sfl(0.0f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    lo = lo + _mm_loadu_ps(a + i) * _mm_loadu_ps(b + i);
+    hi = hi + _mm_loadu_ps(a + i + 4) * _mm_loadu_ps(b + i + 4);
+  }
+
+  v4sf acc4 = lo + hi;
+  float sum = (v4sf_index<0>(acc4) + v4sf_index<1>(acc4)) + (v4sf_index<2>(acc4) + v4sf_index<3>(acc4));
+  for (; i < n; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
 #else
 // PLACEHOLDER for future ARM NEON code
 // Also remember to define HAVE_SIMD_MATHMODE
@@ -386,6 +429,168 @@ void vexpdigammify_2(vw &all, float *gamma, const float *norm, const float under
 
 #endif  // !VW_NO_INLINE_SIMD
 
+// AVX2 versions of the SIMD kernels above, eight floats at a time. They are compiled for AVX2 through a target
+// attribute and selected at run time, so the binary still runs on CPUs that only have SSE2. FMA is deliberately
+// not enabled: every lane performs the same operations as vfastdigamma and vfastexp.
+#if defined(HAVE_SIMD_MATHMODE) && !defined(_WIN32) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+#define HAVE_AVX2_MATHMODE
+#define VW_TARGET_AVX2 __attribute__((target("avx2")))
+
+typedef __m256 v8sf;
+typedef __m256i v8si;
+
+inline bool have_avx2()
+{
+  static const bool supported = __builtin_cpu_supports("avx2") != 0;
+  return supported;
+}
+
+VW_TARGET_AVX2 inline v8sf v8sfl(const float x) { return _mm256_set1_ps(x); }
+
+VW_TARGET_AVX2 inline v8sf vfastpow2_8(const v8sf p)
+{
+  v8sf ltzero = _mm256_cmp_ps(p, v8sfl(0.0f), _CMP_LT_OQ);
+  v8sf offset = _mm256_and_ps(ltzero, v8sfl(1.0f));
+  v8sf lt126 = _mm256_cmp_ps(p, v8sfl(-126.0f), _CMP_LT_OQ);
+  v8sf clipp = _mm256_add_ps(_mm256_andnot_ps(lt126, p), _mm256_and_ps(lt126, v8sfl(-126.0f)));
+  v8si w = _mm256_cvttps_epi32(clipp);
+  v8sf z = _mm256_add_ps(_mm256_sub_ps(clipp, _mm256_cvtepi32_ps(w)), offset);
+
+  v8sf v = _mm256_add_ps(clipp, v8sfl(121.2740838f));
+  v = _mm256_add_ps(v, _mm256_div_ps(v8sfl(27.7280233f), _mm256_sub_ps(v8sfl(4.84252568f), z)));
+  v = _mm256_sub_ps(v, _mm256_mul_ps(v8sfl(1.49012907f), z));
+  v = _mm256_mul_ps(v8sfl(1 << 23), v);
+
+  return _mm256_castsi256_ps(_mm256_cvttps_epi32(v));
+}
+
+VW_TARGET_AVX2 inline v8sf vfastexp_8(const v8sf p) { return vfastpow2_8(_mm256_mul_ps(v8sfl(1.442695040f), p)); }
+
+VW_TARGET_AVX2 inline v8sf vfastlog_8(v8sf x)
+{
+  v8si vx_i = _mm256_castps_si256(x);
+  v8sf mx_f = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(vx_i, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3f000000)));
+  v8sf y = _mm256_mul_ps(_mm256_cvtepi32_ps(vx_i), v8sfl(1.1920928955078125e-7f));
+
+  v8sf log2 = _mm256_sub_ps(y, v8sfl(124.22551499f));
+  log2 = _mm256_sub_ps(log2, _mm256_mul_ps(v8sfl(1.498030302f), mx_f));
+  log2 = _mm256_sub_ps(log2, _mm256_div_ps(v8sfl(1.72587999f), _mm256_add_ps(v8sfl(0.3520887068f), mx_f)));
+
+  return _mm256_mul_ps(v8sfl(0.69314718f), log2);
+}
+
+VW_TARGET_AVX2 inline v8sf vfastdigamma_8(v8sf x)
+{
+  v8sf twopx = _mm256_add_ps(v8sfl(2.0f), x);
+  v8sf logterm = vfastlog_8(twopx);
+
+  v8sf num = _mm256_sub_ps(v8sfl(-127.0f), _mm256_mul_ps(v8sfl(30.0f), x));
+  num = _mm256_add_ps(v8sfl(-157.0f), _mm256_mul_ps(x, num));
+  num = _mm256_add_ps(v8sfl(-48.0f), _mm256_mul_ps(x, num));
+  v8sf den = _mm256_mul_ps(_mm256_mul_ps(v8sfl(12.0f), x), _mm256_add_ps(v8sfl(1.0f), x));
+  den = _mm256_mul_ps(_mm256_mul_ps(den, twopx), twopx);
+
+  return _mm256_add_ps(_mm256_div_ps(num, den), logterm);
+}
+
+// The AVX2 kernels split gamma like the SSE ones: the unaligned head and the last elements one at a time, the aligned
+// middle in vector lanes, eight and then four at a time. Every lane does what vfastdigamma and vfastexp do, so the
+// results are bit identical to the SSE kernels.
+VW_TARGET_AVX2 void vexpdigammify_avx2(vw &all, float *gamma, const float underflow_threshold)
+{
+  const float *fpend = gamma + all.lda;
+  float *fp;
+  float extra_sum = vsum_topics(all, gamma);
+
+  for (fp = gamma; fp < fpend && !is_aligned16(fp); ++fp) *fp = fastdigamma(*fp);
+
+  for (; fp + 8 < fpend; fp += 8) _mm256_storeu_ps(fp, vfastdigamma_8(_mm256_loadu_ps(fp)));
+
+  for (; fp + 4 < fpend; fp += 4) _mm_store_ps(fp, vfastdigamma(_mm_load_ps(fp)));
+
+  for (; fp < fpend; ++fp) *fp = fastdigamma(*fp);
+
+  extra_sum = fastdigamma(extra_sum);
+
+  for (fp = gamma; fp < fpend && !is_aligned16(fp); ++fp) *fp = fmax(underflow_threshold, fastexp(*fp - extra_sum));
+
+  const v8sf vsum = v8sfl(extra_sum);
+  const v8sf threshold = v8sfl(underflow_threshold);
+  for (; fp + 8 < fpend; fp += 8)
+  {
+    v8sf arg = vfastexp_8(_mm256_sub_ps(_mm256_loadu_ps(fp), vsum));
+    _mm256_storeu_ps(fp, _mm256_max_ps(threshold, arg));
+  }
+
+  for (; fp + 4 < fpend; fp += 4)
+  {
+    v4sf arg = vfastexp(_mm_load_ps(fp) - v4sfl(extra_sum));
+    _mm_store_ps(fp, _mm_max_ps(v4sfl(underflow_threshold), arg));
+  }
+
+  for (; fp < fpend; ++fp) *fp = fmax(underflow_threshold, fastexp(*fp - extra_sum));
+}
+
+VW_TARGET_AVX2 void vexpdigammify_2_avx2(vw &all, float *gamma, const float *norm, const float underflow_threshold)
+{
+  const float *fpend = gamma + all.lda;
+  float *fp = gamma;
+  const float *np = norm;
+
+  for (; fp < fpend && !is_aligned16(fp); ++fp, ++np)
+    *fp = fmax(underflow_threshold, fastexp(fastdigamma(*fp) - *np));
+
+  const v8sf threshold = v8sfl(underflow_threshold);
+  for (; fp + 8 < fpend; fp += 8, np += 8)
+  {
+    v8sf arg = _mm256_sub_ps(vfastdigamma_8(_mm256_loadu_ps(fp)), _mm256_loadu_ps(np));
+    _mm256_storeu_ps(fp, _mm256_max_ps(threshold, vfastexp_8(arg)));
+  }
+
+  for (; fp + 4 < fpend; fp += 4, np += 4)
+  {
+    v4sf arg = vfastdigamma(_mm_load_ps(fp)) - _mm_loadu_ps(np);
+    _mm_store_ps(fp, _mm_max_ps(v4sfl(underflow_threshold), vfastexp(arg)));
+  }
+
+  for (; fp < fpend; ++fp, ++np) *fp = fmax(underflow_threshold, fastexp(fastdigamma(*fp) - *np));
+}
+
+// Dot product with eight partial sums, used by the SIMD math mode only since the summation order differs from
+// std::inner_product. Adds up in the same order as vdot.
+VW_TARGET_AVX2 float vdot_avx2(const float *a, const float *b, size_t n)
+{
+  v8sf acc = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+  __m128 acc4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  acc4 = _mm_hadd_ps(acc4, acc4);
+  acc4 = _mm_hadd_ps(acc4, acc4);
+  float sum = _mm_cvtss_f32(acc4);
+  for (; i < n; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+// y += a * x, lane by lane, so the result is identical to the scalar loop.
+VW_TARGET_AVX2 void vaxpy_avx2(float *y, const float *x, float a, size_t n)
+{
+  const v8sf va = v8sfl(a);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(va, _mm256_loadu_ps(x + i))));
+  for (; i < n; ++i) y[i] += a * x[i];
+}
+
+#undef VW_TARGET_AVX2
+
+#endif  // HAVE_AVX2_MATHMODE
+
 // Templates for common code shared between the three math modes (SIMD, fast approximations
 // and accurate).
 //
@@ -505,7 +710,12 @@ inline void expdigammify(vw &all, T *gamma, T threshold, T initial)
 template <>
 inline void expdigammify<float, USE_SIMD>(vw &all, float *gamma, float threshold, float)
 {
-#if defined(HAVE_SIMD_MATHMODE)
+#if defined(HAVE_AVX2_MATHMODE)
+  if (have_avx2())
+    vexpdigammify_avx2(all, gamma, threshold);
+  else
+    vexpdigammify(all, gamma, threshold);
+#elif defined(HAVE_SIMD_MATHMODE)
   vexpdigammify(all, gamma, threshold);
 #else
   // Do something sensible if SIMD math isn't available:
@@ -522,7 +732,12 @@ inline void expdigammify_2(vw &all, float *gamma, T *norm, const T threshold)
 template <>
 inline void expdigammify_2<float, USE_SIMD>(vw &all, float *gamma, float *norm, const float threshold)
 {
-#if defined(HAVE_SIMD_MATHMODE)
+#if defined(HAVE_AVX2_MATHMODE)
+  if (have_avx2())
+    vexpdigammify_2_avx2(all, gamma, norm, threshold);
+  else
+    vexpdigammify_2(all, gamma, norm, threshold);
+#elif defined(HAVE_SIMD_MATHMODE)
   vexpdigammify_2(all, gamma, norm, threshold);
 #else
   // Do something sensible if SIMD math isn't available:
@@ -673,24 +888,38 @@ float theta_kl(lda &l, v_array<float> &Elogtheta, float *gamma)
 
 static inline float find_cw(lda &l, float *u_for_w, float *v)
 {
+#if defined(HAVE_AVX2_MATHMODE)
+  if (l.mmode == USE_SIMD && ldamath::have_avx2()) return 1.0f / ldamath::vdot_avx2(u_for_w, v, l.topics);
+#endif
+#if defined(HAVE_SIMD_MATHMODE)
+  if (l.mmode == USE_SIMD) return 1.0f / ldamath::vdot(u_for_w, v, l.topics);
+#endif
   return 1.0f / std::inner_product(u_for_w, u_for_w + l.topics, v, 0.0f);
 }
 
-namespace
+// new_gamma += xc_w * u_for_w
+static inline void accumulate_gamma(lda &l, float *new_gamma, const float *u_for_w, float xc_w)
 {
-// Effectively, these are static and not visible outside the compilation unit.
-v_array<float> new_gamma = v_init<float>();
-v_array<float> old_gamma = v_init<float>();
-}  // namespace
+#if defined(HAVE_AVX2_MATHMODE)
+  if (ldamath::have_avx2())
+  {
+    ldamath::vaxpy_avx2(new_gamma, u_for_w, xc_w, l.topics);
+    return;
+  }
+#endif
+  for (size_t k = 0; k < l.topics; k++) new_gamma[k] += xc_w * u_for_w[k];
+}
 
 // Returns an estimate of the part of the variational bound that
 // doesn't have to do with beta for the entire corpus for the current
 // setting of lambda based on the document passed in. The value is
 // divided by the total number of words in the document This can be
 // used as a (possibly very noisy) estimate of held-out likelihood.
-float lda_loop(lda &l, v_array<float> &Elogtheta, float *v, example *ec, float)
+float lda_loop(lda &l, lda_inference_scratch &scratch, float *v, example *ec, float)
 {
   parameters &weights = l.all->weights;
+  v_array<float> &new_gamma = scratch.new_gamma;
+  v_array<float> &old_gamma = scratch.old_gamma;
   new_gamma.clear();
   old_gamma.clear();
 
@@ -724,8 +953,7 @@ float lda_loop(lda &l, v_array<float> &Elogtheta, float *v, example *ec, float)
         float c_w = find_cw(l, u_for_w, v);
         xc_w = c_w * f.value();
         score += -f.value() * log(c_w);
-        size_t max_k = l.topics;
-        for (size_t k = 0; k < max_k; k++, ++u_for_w) new_gamma[k] += xc_w * *u_for_w;
+        accumulate_gamma(l, new_gamma.begin(), u_for_w, xc_w);
         word_count++;
         doc_length += f.value();
       }
@@ -738,7 +966,7 @@ float lda_loop(lda &l, v_array<float> &Elogtheta, float *v, example *ec, float)
   memcpy(ec->pred.scalars.begin(), new_gamma.begin(), l.topics * sizeof(float));
   ec->pred.scalars.end() = ec->pred.scalars.begin() + l.topics;
 
-  score += theta_kl(l, Elogtheta, new_gamma.begin());
+  score += theta_kl(l, scratch.Elogtheta, new_gamma.begin());
 
   return score / doc_length;
 }
@@ -762,8 +990,28 @@ struct initial_weights
   bool _random;
   uint32_t _lda;
   uint32_t _stride;
+  float *_total_lambda;
 };
 
+// Index of the model record holding total_lambda. It is written before the weight rows and can never be a row index.
+// Only files from VERSION_FILE_WITH_LDA_TOTAL_LAMBDA on have it, older readers would take it for a weight row.
+constexpr uint64_t total_lambda_record = std::numeric_limits<uint64_t>::max();
+
+void compute_total_lambda(lda &l)
+{
+  // This part does not work with sparse parameters
+  parameters &weights = l.all->weights;
+  size_t stride = weights.stride();
+  l.total_lambda.clear();
+  for (size_t k = 0; k < l.all->lda; k++) l.total_lambda.push_back(0.f);
+  for (size_t i = 0; i <= weights.mask(); i += stride)
+  {
+    weight *w = &(weights[i]);
+    for (size_t k = 0; k < l.all->lda; k++) l.total_lambda[k] += w[k];
+  }
+  l.total_lambda_init = true;
+}
+
 void save_load(lda &l, io_buf &model_file, bool read, bool text)
 {
   vw& all = *(l.all);
@@ -771,8 +1019,12 @@ void save_load(lda &l, io_buf &model_file, bool read, bool text)
   if (read)
   {
     initialize_regressor(all);
+    // The initializer adds every row it sets to total_lambda, which then matches the weights without a sweep.
+    l.total_lambda.clear();
+    for (size_t k = 0; k < all.lda; k++) l.total_lambda.push_back(0.f);
+    l.total_lambda_init = true;
     initial_weights init{all.initial_t, static_cast<float>(l.lda_D / all.lda / all.length() * 200.f), all.random_weights, all.lda,
-        all.weights.stride()};
+        all.weights.stride(), l.total_lambda.begin()};
 
     auto initial_lda_weight_initializer = [init](weight* weights, uint64_t index) {
       uint32_t lda = init._lda;
@@ -782,6 +1034,7 @@ void save_load(lda &l, io_buf &model_file, bool read, bool text)
         for (size_t i = 0; i != lda; ++i, ++index)
         {
           weights[i] = static_cast<float>(-std::log(merand48(index) + 1e-6) + 1.0f) * initial_random;
+          init._total_lambda[i] += weights[i];
         }
       }
       weights[lda] = init._initial;
@@ -794,11 +1047,23 @@ void save_load(lda &l, io_buf &model_file, bool read, bool text)
     uint64_t i = 0;
     std::stringstream msg;
     size_t brw = 1;
+    size_t K = all.lda;
+
+    // Models written before total_lambda was saved only have weight rows, it is recomputed from them on first use.
+    std::vector<float> saved_total_lambda;
+    if (read)
+      l.total_lambda_init = false;
+    else if (!text && l.total_lambda_init && all.model_file_ver >= VERSION_FILE_WITH_LDA_TOTAL_LAMBDA)
+    {
+      uint64_t record = total_lambda_record;
+      bin_text_read_write_fixed(model_file, (char *)&record, sizeof(record), "", read, msg, text);
+      for (size_t k = 0; k < K; k++)
+        bin_text_read_write_fixed(model_file, (char *)&l.total_lambda[k], sizeof(float), "", read, msg, text);
+    }
 
     do
     {
       brw = 0;
-      size_t K = all.lda;
       if (!read && text)
         msg << i << " ";
 
@@ -812,7 +1077,14 @@ void save_load(lda &l, io_buf &model_file, bool read, bool text)
         i = j;
       }
 
-      if (brw != 0)
+      if (brw != 0 && read && i == total_lambda_record && all.model_file_ver >= VERSION_FILE_WITH_LDA_TOTAL_LAMBDA)
+      {
+        saved_total_lambda.resize(K);
+        for (size_t k = 0; k < K; k++)
+          brw += bin_text_read_write_fixed(
+              model_file, (char *)&saved_total_lambda[k], sizeof(float), "", read, msg, text);
+      }
+      else if (brw != 0)
       {
         weight *w = &(all.weights.strided_index(i));
         for (uint64_t k = 0; k < K; k++)
@@ -832,6 +1104,12 @@ void save_load(lda &l, io_buf &model_file, bool read, bool text)
       if (!read)
         ++i;
     } while ((!read && i < length) || (read && brw > 0));
+
+    if (!saved_total_lambda.empty())
+    {
+      std::copy(saved_total_lambda.begin(), saved_total_lambda.end(), l.total_lambda.begin());
+      l.total_lambda_init = true;
+    }
   }
 }
 
@@ -884,17 +1162,8 @@ void learn_batch(lda &l)
   float eta = -1;
   float minuseta = -1;
 
-  if (l.total_lambda.empty())
-  {
-    for (size_t k = 0; k < l.all->lda; k++) l.total_lambda.push_back(0.f);
-    // This part does not work with sparse parameters
-    size_t stride = weights.stride();
-    for (size_t i = 0; i <= weights.mask(); i += stride)
-    {
-      weight *w = &(weights[i]);
-      for (size_t k = 0; k < l.all->lda; k++) l.total_lambda[k] += w[k];
-    }
-  }
+  if (!l.total_lambda_init)
+    compute_total_lambda(l);
 
   l.example_t++;
   l.total_new.clear();
@@ -936,9 +1205,29 @@ void learn_batch(lda &l)
     l.expdigammify_2(*l.all, u_for_w, l.digammas.begin());
   }
 
+  // E-step. Given lambda the documents are independent, so they are split over the threads. Each document is inferred
+  // the same way whatever the number of threads, so the results do not depend on it.
+  l.doc_scores.resize(batch_size);
+  // sparse weights insert on lookup, which is not thread safe
+  const size_t num_threads = l.all->weights.sparse ? 1 : std::max<size_t>(1, std::min(l.threads, batch_size));
+  auto infer_documents = [&l, batch_size, num_threads](size_t thread_id) {
+    for (size_t d = thread_id; d < batch_size; d += num_threads)
+      l.doc_scores[d] =
+          lda_loop(l, l.inference_scratch[thread_id], &(l.v[d * l.all->lda]), l.examples[d], l.all->power_t);
+  };
+  if (num_threads == 1)
+    infer_documents(0);
+  else
+  {
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < num_threads; t++) workers.emplace_back(infer_documents, t);
+    infer_documents(0);
+    for (auto &worker : workers) worker.join();
+  }
+
   for (size_t d = 0; d < batch_size; d++)
   {
-    float score = lda_loop(l, l.Elogtheta, &(l.v[d * l.all->lda]), l.examples[d], l.all->power_t);
+    float score = l.doc_scores[d];
     if (l.all->audit)
       GD::print_audit_features(*l.all, *l.examples[d]);
     // If the doc is empty, give it loss of 0.
@@ -1330,6 +1619,9 @@ VW::LEARNER::base_learner *lda_setup(options_i &options, vw &all)
       .add(make_option("lda_D", ld->lda_D).default_value(10000.0f).help("Number of documents"))
       .add(make_option("lda_epsilon", ld->lda_epsilon).default_value(0.001f).help("Loop convergence threshold"))
       .add(make_option("minibatch", ld->minibatch).default_value(1).help("Minibatch size, for LDA"))
+      .add(make_option("lda_threads", ld->threads)
+               .default_value(1)
+               .help("Number of threads inferring the documents of a minibatch, for LDA"))
       .add(make_option("math-mode", math_mode).default_value(USE_SIMD).help("Math mode: simd, accuracy, fast-approx"))
       .add(make_option("metrics", ld->compute_coherence_metrics).help("Compute metrics"));
   options.add_and_parse(new_options);
@@ -1377,6 +1669,10 @@ VW::LEARNER::base_learner *lda_setup(options_i &options, vw &all)
 
   ld->v.resize(all.lda * ld->minibatch);
 
+  if (ld->threads == 0)
+    THROW("--lda_threads must be at least 1");
+  ld->inference_scratch.resize(ld->threads);
+
   ld->decay_levels.push_back(0.f);
 
   all.p->lp = no_label::no_label_parser;
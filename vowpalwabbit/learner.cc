@@ -8,6 +8,12 @@
 #include "parse_regressor.h"
 #include "parse_dispatch_loop.h"
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #define CASE(type) \
   case type:       \
     return #type;
@@ -138,6 +144,199 @@ class multi_instance_context
   std::vector<vw*> _all;
 };
 
+// instance_worker - runs one vw instance on its own thread over private copies of the examples parsed by the master.
+// Copies are recycled through a free list, so once warmed up no examples are allocated.
+class instance_worker
+{
+ public:
+  instance_worker(vw& all) : _all(all), _thread(&instance_worker::run, this) {}
+
+  ~instance_worker()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done = true;
+    }
+    _work_ready.notify_all();
+    _thread.join();
+
+    for (auto& job : _jobs) release(job.examples);
+    for (example* ec : _free)
+    {
+      VW::dealloc_example(_all.p->lp.delete_label, *ec, _all.delete_prediction);
+      free_it(ec);
+    }
+  }
+
+  template <class T>
+  void push(T& ec)
+  {
+    job new_job;
+    new_job.is_multiline = is_multiline(ec);
+    copy(ec, new_job.examples);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    // bound the amount of copied examples in flight
+    _work_done.wait(lock, [this] { return _jobs.size() < max_pending_jobs; });
+    _jobs.push_back(std::move(new_job));
+    lock.unlock();
+    _work_ready.notify_one();
+  }
+
+  // Blocks until every pushed example was processed.
+  void wait_idle()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _work_done.wait(lock, [this] { return _jobs.empty() && !_busy; });
+  }
+
+ private:
+  static constexpr size_t max_pending_jobs = 256;
+
+  struct job
+  {
+    multi_ex examples;
+    bool is_multiline;
+  };
+
+  static bool is_multiline(const example&) { return false; }
+  static bool is_multiline(const multi_ex&) { return true; }
+
+  example* copy_one(example& src)
+  {
+    example* dst;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_free.empty())
+        dst = nullptr;
+      else
+      {
+        dst = _free.back();
+        _free.pop_back();
+      }
+    }
+    if (dst == nullptr)
+      dst = VW::alloc_examples(_all.p->lp.label_size, 1);
+
+    // like multi_instance_context, every instance sees the interactions of the master that parsed the example
+    VW::copy_example_data(_all.audit, dst, &src, _all.p->lp.label_size, _all.p->lp.copy_label);
+    return dst;
+  }
+
+  void copy(example& ec, multi_ex& out) { out.push_back(copy_one(ec)); }
+  void copy(multi_ex& ec_seq, multi_ex& out)
+  {
+    out.reserve(ec_seq.size());
+    for (example* ec : ec_seq) out.push_back(copy_one(*ec));
+  }
+
+  // must be called with _mutex held
+  void release(multi_ex& examples)
+  {
+    for (example* ec : examples)
+    {
+      VW::empty_example(_all, *ec);
+      _free.push_back(ec);
+    }
+    examples.clear();
+  }
+
+  void run()
+  {
+    while (true)
+    {
+      job current;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _work_ready.wait(lock, [this] { return _done || !_jobs.empty(); });
+        if (_jobs.empty())
+          return;
+        current = std::move(_jobs.front());
+        _jobs.pop_front();
+        _busy = true;
+      }
+
+      // A failing instance stops learning, the error is reported by the driver through its parser like a parse error.
+      if (!_all.p->exc_ptr)
+      {
+        try
+        {
+          if (current.is_multiline)
+            learn_multi_ex(current.examples, _all);
+          else
+            learn_ex(*current.examples[0], _all);
+        }
+        catch (...)
+        {
+          _all.p->exc_ptr = std::current_exception();
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        release(current.examples);
+        _busy = false;
+      }
+      _work_done.notify_all();
+    }
+  }
+
+  vw& _all;
+  std::mutex _mutex;
+  std::condition_variable _work_ready;
+  std::condition_variable _work_done;
+  std::deque<job> _jobs;
+  std::vector<example*> _free;
+  bool _busy = false;
+  bool _done = false;
+  // declared last so that every other member is constructed before the thread starts
+  std::thread _thread;
+};
+
+// parallel_multi_instance_context - multi_instance_context where every instance but the master learns on its own
+// thread. The master parses the data once, each worker learns from its own copy of every example, and the master
+// learns from the originals. Commands (end of pass, save) wait for the workers and then run on all instances in order.
+class parallel_multi_instance_context
+{
+ public:
+  parallel_multi_instance_context(const std::vector<vw*>& all) : _all(all), _workers(std::make_shared<workers>())
+  {
+    for (size_t i = 1; i < all.size(); i++) _workers->emplace_back(new instance_worker(*all[i]));
+  }
+
+  vw& get_master() const { return *_all.front(); }
+
+  template <class T, void (*process_impl)(T&, vw&)>
+  void process(T& ec)
+  {
+    if (is_learn(process_impl))
+    {
+      for (auto& worker : *_workers) worker->push(ec);
+      process_impl(ec, get_master());
+    }
+    else
+    {
+      for (auto& worker : *_workers) worker->wait_idle();
+      for (auto it = _all.rbegin(); it != _all.rend(); ++it) process_impl(ec, **it);
+    }
+  }
+
+  void wait_idle()
+  {
+    for (auto& worker : *_workers) worker->wait_idle();
+  }
+
+ private:
+  using workers = std::vector<std::unique_ptr<instance_worker>>;
+
+  static bool is_learn(void (*process_impl)(example&, vw&)) { return process_impl == learn_ex; }
+  static bool is_learn(void (*process_impl)(multi_ex&, vw&)) { return process_impl == learn_multi_ex; }
+
+  std::vector<vw*> _all;
+  // shared by the copies the example handlers keep
+  std::shared_ptr<workers> _workers;
+};
+
 // single_example_handler / multi_example_handler - consumer classes with on_example handle method, incapsulating
 // creation of example / multi_ex and passing it to context.process
 template <typename context_type>
@@ -285,6 +484,14 @@ void generic_driver(const std::vector<vw*>& all)
   generic_driver(examples, context);
 }
 
+void generic_driver_parallel(const std::vector<vw*>& all)
+{
+  parallel_multi_instance_context context(all);
+  ready_examples_queue examples(context.get_master());
+  generic_driver(examples, context);
+  context.wait_idle();
+}
+
 template <typename handler_type>
 void generic_driver_onethread(vw& all)
 {
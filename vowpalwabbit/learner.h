@@ -109,6 +109,8 @@ struct finish_example_data
 
 void generic_driver(vw& all);
 void generic_driver(const std::vector<vw*>& alls);
+// Like generic_driver(alls), but each instance after the first learns on its own thread from a copy of the examples.
+void generic_driver_parallel(const std::vector<vw*>& alls);
 void generic_driver_onethread(vw& all);
 
 inline void noop_sl(void*, io_buf&, bool, bool) {}
@@ -130,6 +132,24 @@ inline void increment_offset(multi_ex& ec_seq, const size_t increment, const siz
   for (auto ec : ec_seq) ec->ft_offset += static_cast<uint32_t>(increment * i);
 }
 
+// Stores the prediction of the c-th model for multipredict.
+inline void store_multiprediction(example& ec, polyprediction* pred, const size_t c, const bool finalize_predictions)
+{
+  if (finalize_predictions)
+    pred[c] = ec.pred;  // TODO: this breaks for complex labels because = doesn't do deep copy!
+  else
+    pred[c].scalar = ec.partial_prediction;
+  // pred[c].scalar = finalize_prediction ec.partial_prediction; // TODO: this breaks for complex labels because =
+  // doesn't do deep copy! // note works if ec.partial_prediction, but only if finalize_prediction is run????
+}
+
+// Multiline multipredict returns the raw score of every example for every model: the score of example k under the
+// c-th model is pred[c * ec_seq.size() + k].scalar.
+inline void store_multiprediction(multi_ex& ec_seq, polyprediction* pred, const size_t c, const bool)
+{
+  for (size_t k = 0; k < ec_seq.size(); k++) pred[c * ec_seq.size() + k].scalar = ec_seq[k]->partial_prediction;
+}
+
 inline void decrement_offset(example& ex, const size_t increment, const size_t i)
 {
   assert(ex.ft_offset >= increment * i);
@@ -188,6 +208,9 @@ struct learner
   size_t weights;  // this stores the number of "weight vectors" required by the learner.
   size_t increment;
   bool is_multiline;  // Is this a single-line or multi-line reduction?
+  // Does this reduction or one below it add features to the namespaces of the examples it is given? Inherited from
+  // the base in init_learner, so a reduction can tell whether the feature groups it hands down are modified.
+  bool writes_features;
 
   using end_fptr_type = void (*)(vw&, void*, void*);
   using finish_fptr_type = void (*)(void*);
@@ -237,12 +260,7 @@ struct learner
       for (size_t c = 0; c < count; c++)
       {
         learn_fd.predict_f(learn_fd.data, *learn_fd.base, (void*)&ec);
-        if (finalize_predictions)
-          pred[c] = ec.pred;  // TODO: this breaks for complex labels because = doesn't do deep copy!
-        else
-          pred[c].scalar = ec.partial_prediction;
-        // pred[c].scalar = finalize_prediction ec.partial_prediction; // TODO: this breaks for complex labels because =
-        // doesn't do deep copy! // note works if ec.partial_prediction, but only if finalize_prediction is run????
+        store_multiprediction(ec, pred, c, finalize_predictions);
         increment_offset(ec, increment, 1);
       }
       decrement_offset(ec, increment, lo + count);
@@ -409,6 +427,9 @@ VW_WARNING_DISABLE_CAST_FUNC_TYPE
 VW_WARNING_STATE_POP
   }
 
+  // For reductions that push features into, or rewrite, the feature groups of the examples they are given.
+  void set_writes_features() { writes_features = true; }
+
   template <class L>
   static learner<T, E>& init_learner(T* dat, L* base, void (*learn)(T&, L&, E&), void (*predict)(T&, L&, E&), size_t ws,
       prediction_type_t pred_type)
@@ -588,21 +609,27 @@ single_learner* as_singleline(learner<T, E>* l)
 template <bool is_learn>
 void multiline_learn_or_predict(multi_learner& base, multi_ex& examples, const uint64_t offset, const uint32_t id = 0)
 {
+  // Examples of one multi_ex almost always share a single offset, so only fall back to saving
+  // every offset when they differ.  This keeps the common path free of allocations.
+  const uint64_t common_offset = examples.empty() ? 0 : examples[0]->ft_offset;
+  bool uniform = true;
+  for (auto ec : examples) uniform &= (ec->ft_offset == common_offset);
+
   std::vector<uint64_t> saved_offsets;
-  saved_offsets.reserve(examples.size());
-  for (auto ec : examples)
+  if (!uniform)
   {
-    saved_offsets.push_back(ec->ft_offset);
-    ec->ft_offset = offset;
+    saved_offsets.reserve(examples.size());
+    for (auto ec : examples) saved_offsets.push_back(ec->ft_offset);
   }
+  for (auto ec : examples) ec->ft_offset = offset;
 
   // Guard example state restore against throws
   auto restore_guard = VW::scope_exit(
-    [&saved_offsets, &examples]
+    [&saved_offsets, &examples, uniform, common_offset]
     {
       for (size_t i = 0; i < examples.size(); i++)
       {
-        examples[i]->ft_offset = saved_offsets[i];
+        examples[i]->ft_offset = uniform ? common_offset : saved_offsets[i];
       }
     });
 
@@ -66,16 +66,22 @@ vw* setup(options_i& options)
 int main(int argc, char* argv[])
 {
   bool should_use_onethread = false;
+  bool parallel_args = false;
   option_group_definition driver_config("driver");
-  driver_config.add(make_option("onethread", should_use_onethread).help("Disable parse thread"));
+  driver_config.add(make_option("onethread", should_use_onethread).help("Disable parse thread"))
+      .add(make_option("parallel_args", parallel_args)
+               .help("Given as vw --args <file> --parallel_args, learn each line's model on its own thread from one "
+                     "parse of the data"));
 
   try
   {
     // support multiple vw instances for training of the same datafile for the same instance
     std::vector<std::unique_ptr<options_boost_po>> arguments;
     std::vector<vw*> alls;
-    if (argc == 3 && !std::strcmp(argv[1], "--args"))
+    bool should_run_parallel = false;
+    if ((argc == 3 || (argc == 4 && !std::strcmp(argv[3], "--parallel_args"))) && !std::strcmp(argv[1], "--args"))
     {
+      should_run_parallel = argc == 4;
       std::fstream arg_file(argv[2]);
       if (!arg_file)
       {
@@ -98,6 +104,8 @@ int main(int argc, char* argv[])
 
         std::unique_ptr<options_boost_po> ptr(new options_boost_po(l_argc, l_argv));
         ptr->add_and_parse(driver_config);
+        if (parallel_args)
+          THROW("--parallel_args goes on the command line after --args <file>, not on a line of the file");
         alls.push_back(setup(*ptr));
         arguments.push_back(std::move(ptr));
       }
@@ -106,6 +114,8 @@ int main(int argc, char* argv[])
     {
       std::unique_ptr<options_boost_po> ptr(new options_boost_po(argc, argv));
       ptr->add_and_parse(driver_config);
+      if (parallel_args)
+        THROW("--parallel_args is only valid as vw --args <file> --parallel_args");
       alls.push_back(setup(*ptr));
       arguments.push_back(std::move(ptr));
     }
@@ -124,6 +134,8 @@ int main(int argc, char* argv[])
       VW::start_parser(all);
       if (alls.size() == 1)
         VW::LEARNER::generic_driver(all);
+      else if (should_run_parallel)
+        VW::LEARNER::generic_driver_parallel(alls);
       else
         VW::LEARNER::generic_driver(alls);
       VW::end_parser(all);
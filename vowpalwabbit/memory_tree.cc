@@ -16,6 +16,11 @@
 #include "vw.h"
 #include "v_array.h"
 #include "future_compat.h"
+#include "sparse_dot.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>  // __popcnt64
+#endif
 
 using namespace VW::LEARNER;
 using namespace VW::config;
@@ -215,6 +220,28 @@ struct memory_tree
 
   example* kprod_ec;
 
+  // Flattened features of the stored examples, kept back to back in one arena. An example is flattened the first
+  // time it is compared to a query; stored examples never change their features, so it is never redone.
+  std::vector<uint64_t> flat_indices;
+  std::vector<float> flat_values;
+  std::vector<size_t> flat_begin;  // offset of each stored example in the arena, SIZE_MAX until flattened
+  std::vector<size_t> flat_size;
+  std::vector<float> flat_norm_sq;
+  features flat_scratch;
+
+  // The query being compared to the stored examples, see flatten_query.
+  features query_fs;
+  float query_norm_sq;
+
+  // Approximate leaf search: at predict time only the lsh_candidates examples of a leaf whose random projection
+  // signature is closest to the one of the query are scored. lsh_bits = 0 scans the leaves exactly.
+  uint32_t lsh_bits;
+  uint32_t lsh_candidates;
+  std::vector<uint64_t> lsh_signature;  // per stored example, valid where lsh_indexed is set
+  std::vector<bool> lsh_indexed;
+  std::vector<std::pair<uint32_t, uint32_t>> lsh_ranked;  // (Hamming distance, position in the leaf)
+  std::vector<uint32_t> lsh_selected;
+
   memory_tree()
   {
     // nodes = v_init<node>();
@@ -241,43 +268,48 @@ struct memory_tree
   }
 };
 
-float linear_kernel(const flat_example* fec1, const flat_example* fec2)
-{
-  float dotprod = 0;
+// Flattens ec as the query for the following normalized_linear_prod calls.
+void flatten_query(memory_tree& b, example& ec) { b.query_norm_sq = flatten_sort_features(*b.all, &ec, b.query_fs); }
 
-  features& fs_1 = (features&)fec1->fs;
-  features& fs_2 = (features&)fec2->fs;
-  if (fs_2.indicies.size() == 0)
-    return 0.f;
+void clear_flat_memory(memory_tree& b)
+{
+  b.flat_indices.clear();
+  b.flat_values.clear();
+  b.flat_begin.clear();
+  b.flat_size.clear();
+  b.flat_norm_sq.clear();
+  b.lsh_signature.clear();
+  b.lsh_indexed.clear();
+}
 
-  for (size_t idx1 = 0, idx2 = 0; idx1 < fs_1.size() && idx2 < fs_2.size(); idx1++)
+// Adds the stored example at loc to the arena if it is not there yet.
+void flatten_memory(memory_tree& b, uint32_t loc)
+{
+  if (loc >= b.flat_begin.size())
   {
-    uint64_t ec1pos = fs_1.indicies[idx1];
-    uint64_t ec2pos = fs_2.indicies[idx2];
-    if (ec1pos < ec2pos)
-      continue;
-
-    while (ec1pos > ec2pos && ++idx2 < fs_2.size()) ec2pos = fs_2.indicies[idx2];
-
-    if (ec1pos == ec2pos)
-    {
-      dotprod += fs_1.values[idx1] * fs_2.values[idx2];
-      ++idx2;
-    }
+    b.flat_begin.resize(b.examples.size(), SIZE_MAX);
+    b.flat_size.resize(b.examples.size(), 0);
+    b.flat_norm_sq.resize(b.examples.size(), 0.f);
+  }
+  if (b.flat_begin[loc] == SIZE_MAX)
+  {
+    features& fs = b.flat_scratch;
+    b.flat_norm_sq[loc] = flatten_sort_features(*b.all, b.examples[loc], fs);
+    b.flat_begin[loc] = b.flat_indices.size();
+    b.flat_size[loc] = fs.size();
+    b.flat_indices.insert(b.flat_indices.end(), fs.indicies.begin(), fs.indicies.end());
+    b.flat_values.insert(b.flat_values.end(), fs.values.begin(), fs.values.end());
   }
-  return dotprod;
 }
 
-float normalized_linear_prod(memory_tree& b, example* ec1, example* ec2)
+// Cosine similarity between the current query and the stored example at loc.
+float normalized_linear_prod(memory_tree& b, uint32_t loc)
 {
-  flat_example* fec1 = flatten_sort_example(*b.all, ec1);
-  flat_example* fec2 = flatten_sort_example(*b.all, ec2);
-  float norm_sqrt = std::pow(fec1->total_sum_feat_sq * fec2->total_sum_feat_sq, 0.5f);
-  float linear_prod = linear_kernel(fec1, fec2);
-  // fec1->fs.delete_v();
-  // fec2->fs.delete_v();
-  free_flatten_example(fec1);
-  free_flatten_example(fec2);
+  flatten_memory(b, loc);
+  const size_t begin = b.flat_begin[loc];
+  float norm_sqrt = std::pow(b.query_norm_sq * b.flat_norm_sq[loc], 0.5f);
+  float linear_prod = VW::sparse_dot(b.query_fs.indicies.begin(), b.query_fs.values.begin(), b.query_fs.size(),
+      b.flat_indices.data() + begin, b.flat_values.data() + begin, b.flat_size[loc]);
   return linear_prod / norm_sqrt;
 }
 
@@ -613,30 +645,108 @@ inline uint32_t compute_hamming_loss_via_oas(
   return hamming_loss(ec.l.multilabels.label_v, selected_labs);
 }
 
+// Bit k gives the sign of the k-th random hyperplane at the given feature index.
+inline uint64_t hyperplane_signs(uint64_t index)
+{
+  uint64_t z = index + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Side of each of the b.lsh_bits random hyperplanes the feature vector lies on. The fraction of differing bits
+// between two signatures estimates the angle between the vectors, so it orders examples like the cosine similarity.
+uint64_t compute_lsh_signature(const memory_tree& b, const uint64_t* indices, const float* values, size_t n)
+{
+  float proj[64] = {0.f};
+  for (size_t i = 0; i < n; i++)
+  {
+    const uint64_t signs = hyperplane_signs(indices[i]);
+    for (uint32_t k = 0; k < b.lsh_bits; k++) proj[k] += ((signs >> k) & 1) ? values[i] : -values[i];
+  }
+  uint64_t signature = 0;
+  for (uint32_t k = 0; k < b.lsh_bits; k++)
+    if (proj[k] >= 0.f)
+      signature |= (uint64_t)1 << k;
+  return signature;
+}
+
+// Computes the signature of the stored example at loc if it is not known yet.
+void lsh_index(memory_tree& b, uint32_t loc)
+{
+  if (loc >= b.lsh_indexed.size())
+  {
+    b.lsh_signature.resize(b.examples.size(), 0);
+    b.lsh_indexed.resize(b.examples.size(), false);
+  }
+  if (!b.lsh_indexed[loc])
+  {
+    flatten_memory(b, loc);
+    const size_t begin = b.flat_begin[loc];
+    b.lsh_signature[loc] =
+        compute_lsh_signature(b, b.flat_indices.data() + begin, b.flat_values.data() + begin, b.flat_size[loc]);
+    b.lsh_indexed[loc] = true;
+  }
+}
+
+inline uint32_t hamming_distance(uint64_t a, uint64_t b)
+{
+#ifdef _MSC_VER
+  return (uint32_t)__popcnt64(a ^ b);
+#else
+  return (uint32_t)__builtin_popcountll(a ^ b);
+#endif
+}
+
+// The b.lsh_candidates examples of the leaf whose signature is closest to the one of the current query, in leaf order.
+const std::vector<uint32_t>& select_lsh_candidates(memory_tree& b, const std::vector<uint32_t>& leaf)
+{
+  const uint64_t query_signature =
+      compute_lsh_signature(b, b.query_fs.indicies.begin(), b.query_fs.values.begin(), b.query_fs.size());
+  b.lsh_ranked.clear();
+  for (uint32_t i = 0; i < leaf.size(); i++)
+  {
+    lsh_index(b, leaf[i]);
+    b.lsh_ranked.emplace_back(hamming_distance(query_signature, b.lsh_signature[leaf[i]]), i);
+  }
+  std::nth_element(b.lsh_ranked.begin(), b.lsh_ranked.begin() + b.lsh_candidates, b.lsh_ranked.end());
+
+  b.lsh_selected.clear();
+  for (uint32_t i = 0; i < b.lsh_candidates; i++) b.lsh_selected.push_back(b.lsh_ranked[i].second);
+  std::sort(b.lsh_selected.begin(), b.lsh_selected.end());
+  for (auto& pos : b.lsh_selected) pos = leaf[pos];
+  return b.lsh_selected;
+}
+
 // pick up the "closest" example in the leaf using the score function.
-int64_t pick_nearest(memory_tree& b, single_learner& base, const uint64_t cn, example& ec)
+// With approximate set and --leaf_lsh_bits, only the candidates from select_lsh_candidates are scored.
+int64_t pick_nearest(memory_tree& b, single_learner& base, const uint64_t cn, example& ec, bool approximate = false)
 {
   if (b.nodes[cn].examples_index.size() > 0)
   {
     float max_score = -FLT_MAX;
     int64_t max_pos = -1;
-    for (size_t i = 0; i < b.nodes[cn].examples_index.size(); i++)
+    flatten_query(b, ec);
+    const std::vector<uint32_t>& leaf = b.nodes[cn].examples_index;
+    const std::vector<uint32_t>& candidates =
+        (approximate && b.lsh_bits > 0 && leaf.size() > b.lsh_candidates) ? select_lsh_candidates(b, leaf) : leaf;
+    for (size_t i = 0; i < candidates.size(); i++)
     {
       float score = 0.f;
-      uint32_t loc = b.nodes[cn].examples_index[i];
+      uint32_t loc = candidates[i];
 
       // do not use reward to update memory tree during the very first pass
       //(which is for unsupervised training for memory tree)
       if (b.learn_at_leaf == true && b.current_pass >= 1)
       {
-        float tmp_s = normalized_linear_prod(b, &ec, b.examples[loc]);
+        float tmp_s = normalized_linear_prod(b, loc);
         diag_kronecker_product_test(ec, *b.examples[loc], *b.kprod_ec, b.oas);
         b.kprod_ec->l.simple = {FLT_MAX, 0., tmp_s};
         base.predict(*b.kprod_ec, b.max_routers);
         score = b.kprod_ec->partial_prediction;
       }
       else
-        score = normalized_linear_prod(b, &ec, b.examples[loc]);
+        score = normalized_linear_prod(b, loc);
 
       if (score > max_score)
       {
@@ -710,7 +820,7 @@ void predict(memory_tree& b, single_learner& base, example& ec)
   int64_t closest_ec = 0;
   if (b.oas == false)
   {
-    closest_ec = pick_nearest(b, base, cn, ec);
+    closest_ec = pick_nearest(b, base, cn, ec, true);
     if (closest_ec != -1)
       ec.pred.multiclass = b.examples[closest_ec]->l.multi.label;
     else
@@ -725,7 +835,7 @@ void predict(memory_tree& b, single_learner& base, example& ec)
   else
   {
     float reward = 0.f;
-    closest_ec = pick_nearest(b, base, cn, ec);
+    closest_ec = pick_nearest(b, base, cn, ec, true);
     if (closest_ec != -1)
     {
       reward = F1_score_for_two_examples(ec, *b.examples[closest_ec]);
@@ -792,7 +902,8 @@ float return_reward_from_node(memory_tree& b, single_learner& base, uint64_t cn,
 
   if (b.learn_at_leaf == true && closest_ec != -1)
   {
-    float score = normalized_linear_prod(b, &ec, b.examples[closest_ec]);
+    // pick_nearest already flattened ec as the query
+    float score = normalized_linear_prod(b, (uint32_t)closest_ec);
     diag_kronecker_product_test(ec, *b.examples[closest_ec], *b.kprod_ec, b.oas);
     b.kprod_ec->l.simple = {reward, 1.f, -score};
     b.kprod_ec->weight = weight;
@@ -820,7 +931,8 @@ void learn_at_leaf_random(
   {
     if (b.examples[ec_id]->l.multi.label == ec.l.multi.label)
       reward = 1.f;
-    float score = normalized_linear_prod(b, &ec, b.examples[ec_id]);
+    flatten_query(b, ec);
+    float score = normalized_linear_prod(b, (uint32_t)ec_id);
     diag_kronecker_product_test(ec, *b.examples[ec_id], *b.kprod_ec, b.oas);
     b.kprod_ec->l.simple = {reward, 1.f, -score};
     b.kprod_ec->weight = weight;  //* b.nodes[leaf_id].examples_index.size();
@@ -987,6 +1099,8 @@ void insert_example(memory_tree& b, single_learner& base, const uint32_t& ec_arr
   if ((b.nodes[cn].internal == -1) && (fake_insert == false))  // get to leaf:
   {
     b.nodes[cn].examples_index.push_back(ec_array_index);
+    if (b.lsh_bits > 0)
+      lsh_index(b, ec_array_index);
     if (b.nodes[cn].examples_index.size() > b.max_ex_in_leaf)
     {
       b.max_ex_in_leaf = b.nodes[cn].examples_index.size();
@@ -1217,6 +1331,7 @@ void save_load_memory_tree(memory_tree& b, io_buf& model_file, bool read, bool t
     writeitvar(b.examples.size(), "examples", n_examples);
     if (read)
     {
+      clear_flat_memory(b);
       b.examples.clear();
       for (uint32_t i = 0; i < n_examples; i++)
       {
@@ -1258,13 +1373,28 @@ base_learner* memory_tree_setup(options_i& options, vw& all)
       .add(make_option("dream_at_update", tree->dream_at_update)
                .default_value(0)
                .help("turn on dream operations at reward based update as well"))
-      .add(make_option("online", tree->online).help("turn on dream operations at reward based update as well"));
+      .add(make_option("online", tree->online).help("turn on dream operations at reward based update as well"))
+      .add(make_option("leaf_lsh_bits", tree->lsh_bits)
+               .default_value(0)
+               .help("at prediction, rank the examples of a leaf by a random projection signature of <n> bits (at "
+                     "most 64) and only score the closest ones. 0 scans the leaves exactly (default)"))
+      .add(make_option("leaf_lsh_candidates", tree->lsh_candidates)
+               .default_value(16)
+               .help("number of examples per leaf scored with --leaf_lsh_bits, more is slower with better recall "
+                     "(default 16)"));
   options.add_and_parse(new_options);
   if (!tree->max_nodes)
   {
     return nullptr;
   }
 
+  if (tree->lsh_bits > 64)
+    THROW("--leaf_lsh_bits can be at most 64");
+  if (tree->lsh_bits == 0 && options.was_supplied("leaf_lsh_candidates"))
+    THROW("--leaf_lsh_candidates requires --leaf_lsh_bits");
+  if (tree->lsh_bits > 0 && tree->lsh_candidates == 0)
+    THROW("--leaf_lsh_candidates must be at least 1");
+
   tree->all = &all;
   tree->_random_state = all.get_random_state();
   tree->current_pass = 0;
@@ -1282,6 +1412,9 @@ base_learner* memory_tree_setup(options_i& options, vw& all)
                       << "alpha = " << tree->alpha << " "
                       << "oas = " << tree->oas << " "
                       << "online =" << tree->online << " " << std::endl;
+  if (!all.logger.quiet && tree->lsh_bits > 0)
+    all.trace_message << "memory_tree: leaf search with " << tree->lsh_bits << " bit signatures, "
+                      << tree->lsh_candidates << " candidates per leaf" << std::endl;
 
   size_t num_learners = 0;
 
@@ -213,5 +213,6 @@ base_learner* mf_setup(options_i& options, vw& all)
 
   learner<mf, example>& l =
       init_learner(data, as_singleline(setup_base(options, all)), learn, predict<false>, 2 * data->rank + 1);
+  l.set_writes_features();
   return make_base(l);
 }
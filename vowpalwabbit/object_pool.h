@@ -7,6 +7,7 @@
 #include <set>
 #include <queue>
 #include <stack>
+#include <vector>
 
 // Mutex and CV cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed
 // project.
@@ -167,7 +168,9 @@ struct value_object_pool
   size_t size() const { return m_pool.size(); }
 
  private:
-  std::stack<T> m_pool;
+  // backed by a vector, which keeps its capacity when objects are taken out, so a pool that is drained and refilled
+  // for every example does not allocate once it has reached its working size
+  std::stack<T, std::vector<T>> m_pool;
   TAllocator m_allocator;
   TDeleter m_deleter;
 };
@@ -1268,7 +1268,10 @@ VW::LEARNER::base_learner* setup_base(options_i& options, vw& all)
   if (base == nullptr)
     return setup_base(options, all);
   else
+  {
+    all.enabled_reductions.push_back(setup_func);
     return base;
+  }
 }
 
 void parse_reductions(options_i& options, vw& all)
@@ -1347,6 +1350,12 @@ void parse_reductions(options_i& options, vw& all)
   all.reduction_stack.push(audit_regressor_setup);
 
   all.l = setup_base(options, all);
+
+  // These are gd options, which the other base learners never parse.
+  if ((options.was_supplied("allreduce_async") || options.was_supplied("allreduce_mix")) &&
+      std::find(all.enabled_reductions.begin(), all.enabled_reductions.end(), GD::setup) ==
+          all.enabled_reductions.end())
+    THROW("--allreduce_async and --allreduce_mix require the gd base learner");
 }
 
 vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_context)
@@ -1409,6 +1418,8 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
     size_t unique_id_arg;
     size_t total_arg;
     size_t node_arg;
+    size_t shm_nodes_per_host_arg;
+    float shm_timeout_arg;
     option_group_definition parallelization_args("Parallelization options");
     parallelization_args
         .add(make_option("span_server", span_server_arg).help("Location of server for setting up spanning tree"))
@@ -1419,7 +1430,14 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
         .add(make_option("node", node_arg).default_value(0).help("node number in cluster parallel job"))
         .add(make_option("span_server_port", span_server_port_arg)
                  .default_value(26543)
-                 .help("Port of the server for setting up spanning tree"));
+                 .help("Port of the server for setting up spanning tree"))
+        .add(make_option("shm_nodes_per_host", shm_nodes_per_host_arg)
+                 .help("Reduce over shared memory between this many nodes on each host, numbered host by host. "
+                       "Hosts reduce with each other through the span server"))
+        .add(make_option("shm_timeout", shm_timeout_arg)
+                 .default_value(600.f)
+                 .help("Seconds a --shm_nodes_per_host process waits for the others before giving up, 0 for no "
+                       "limit. A process that exits is noticed regardless"));
     options.add_and_parse(parallelization_args);
 
     // total, unique_id and node must be specified together.
@@ -1429,7 +1447,28 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
       THROW("you must specificy unique_id, total, and node if you specify any");
     }
 
-    if (options.was_supplied("span_server"))
+    if (options.was_supplied("shm_nodes_per_host"))
+    {
+      if (!options.was_supplied("total"))
+        THROW("--shm_nodes_per_host requires unique_id, total and node");
+      if (shm_nodes_per_host_arg == 0 || total_arg % shm_nodes_per_host_arg != 0)
+        THROW("--total must be a multiple of --shm_nodes_per_host");
+
+      // only the first node of each host talks to the other hosts
+      const size_t host = node_arg / shm_nodes_per_host_arg;
+      AllReduceSockets* inter_host = nullptr;
+      if (options.was_supplied("span_server") && node_arg % shm_nodes_per_host_arg == 0)
+        inter_host = new AllReduceSockets(span_server_arg, span_server_port_arg, unique_id_arg,
+            total_arg / shm_nodes_per_host_arg, host, all.logger.quiet);
+      else if (!options.was_supplied("span_server") && total_arg != shm_nodes_per_host_arg)
+        THROW("nodes on more than one host need --span_server");
+
+      all.all_reduce_type = AllReduceType::SharedMemory;
+      all.all_reduce = new AllReduceSharedMemory("/vw_allreduce_" + std::to_string(unique_id_arg) + "_" +
+              std::to_string(host),
+          total_arg, node_arg, shm_nodes_per_host_arg, inter_host, all.logger.quiet, shm_timeout_arg);
+    }
+    else if (options.was_supplied("span_server"))
     {
       all.all_reduce_type = AllReduceType::Socket;
       all.all_reduce = new AllReduceSockets(
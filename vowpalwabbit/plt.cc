@@ -37,6 +37,7 @@ struct plt
   uint32_t kary;  // kary tree
 
   // for training
+  bool fused_learn;                             // score the children of a positive node with one multipredict
   v_array<float> nodes_time;                    // in case of sgd, this stores individual t for each node
   std::unordered_set<uint32_t> positive_nodes;  // container for positive nodes
   std::unordered_set<uint32_t> negative_nodes;  // container for negative nodes
@@ -44,8 +45,11 @@ struct plt
   // for prediction
   float threshold;
   uint32_t top_k;
+  uint32_t beam_width;                 // number of nodes kept per tree level in top-k prediction, 0 for exact search
   v_array<polyprediction> node_preds;  // for storing results of base.multipredict
   std::vector<node> node_queue;        // container for queue used for both types of predictions
+  std::vector<node> beam_next;         // nodes of the next tree level in beam search
+  std::vector<node> beam_leaves;       // leaves reached by beam search
 
   // for measuring predictive performance
   std::unordered_set<uint32_t> true_labels;
@@ -86,6 +90,41 @@ inline void learn_node(plt& p, uint32_t n, single_learner& base, example& ec)
   base.learn(ec, n);
 }
 
+// Like learn_node, for an example whose prediction for node n is already in ec.pred.scalar.
+inline void update_node(plt& p, uint32_t n, single_learner& base, example& ec)
+{
+  if (!p.all->weights.adaptive)
+  {
+    p.all->sd->t = p.nodes_time[n];
+    p.nodes_time[n] += ec.weight;
+  }
+  base.update(ec, n);
+}
+
+// Learns the children of each positive internal node together: one multipredict scores all of them in a single pass
+// over the features, then each child is updated from its score. Compared to learning node by node, nodes are updated
+// parent by parent, positive and negative children mixed, instead of all positive nodes first and then all negative
+// ones, and a child is predicted before its siblings are updated. The model can therefore differ where node weights
+// collide in the hash space, and through the order in which updates add to the global normalized state.
+void learn_children_fused(plt& p, single_learner& base, example& ec)
+{
+  for (auto& n : p.positive_nodes)
+  {
+    uint32_t n_child = p.kary * n + 1;
+    if (n >= p.ti || n_child >= p.t) continue;
+    const uint32_t count = std::min(p.kary, p.t - n_child);
+
+    ec.l.simple = {FLT_MAX, 1.f, 0.f};
+    base.multipredict(ec, n_child, count, p.node_preds.begin(), true);
+    for (uint32_t i = 0; i < count; ++i, ++n_child)
+    {
+      ec.l.simple = {p.positive_nodes.count(n_child) ? 1.f : -1.f, 1.f, 0.f};
+      ec.partial_prediction = ec.pred.scalar = p.node_preds[i].scalar;
+      update_node(p, n_child, base, ec);
+    }
+  }
+}
+
 void learn(plt& p, single_learner& base, example& ec)
 {
   MULTILABEL::labels multilabels = std::move(ec.l.multilabels);
@@ -133,11 +172,21 @@ void learn(plt& p, single_learner& base, example& ec)
   else
     p.negative_nodes.insert(0);
 
-  ec.l.simple = {1.f, 1.f, 0.f};
-  for (auto& n : p.positive_nodes) learn_node(p, n, base, ec);
+  if (p.fused_learn && !p.positive_nodes.empty())
+  {
+    // the root is the only positive node that is not a child of another one
+    ec.l.simple = {1.f, 1.f, 0.f};
+    learn_node(p, 0, base, ec);
+    learn_children_fused(p, base, ec);
+  }
+  else
+  {
+    ec.l.simple = {1.f, 1.f, 0.f};
+    for (auto& n : p.positive_nodes) learn_node(p, n, base, ec);
 
-  ec.l.simple.label = -1.f;
-  for (auto& n : p.negative_nodes) learn_node(p, n, base, ec);
+    ec.l.simple.label = -1.f;
+    for (auto& n : p.negative_nodes) learn_node(p, n, base, ec);
+  }
 
   p.all->sd->t = t;
   p.all->sd->weighted_holdout_examples = weighted_holdout_examples;
@@ -153,6 +202,54 @@ inline float predict_node(uint32_t n, single_learner& base, example& ec)
   return 1.0f / (1.0f + exp(-ec.partial_prediction));
 }
 
+inline bool node_is_more_probable(const node& a, const node& b) { return a.p > b.p || (a.p == b.p && a.n < b.n); }
+
+// Top-k prediction that keeps only the beam_width most probable nodes of each tree level. The children of a level
+// are scored with one multipredict per run of consecutive node numbers, as consecutive nodes have consecutive
+// children.
+void predict_top_k_beam(plt& p, single_learner& base, example& ec, v_array<uint32_t>& labels)
+{
+  p.beam_leaves.clear();
+  p.node_queue.push_back({0, predict_node(0, base, ec)});  // here queue holds the current tree level
+
+  while (!p.node_queue.empty())
+  {
+    std::sort(p.node_queue.begin(), p.node_queue.end(), [](const node& a, const node& b) { return a.n < b.n; });
+    p.beam_next.clear();
+    for (size_t first = 0; first < p.node_queue.size();)
+    {
+      size_t last = first + 1;
+      while (last < p.node_queue.size() && p.node_queue[last].n == p.node_queue[last - 1].n + 1) ++last;
+
+      uint32_t n_child = p.kary * p.node_queue[first].n + 1;
+      const size_t count = (last - first) * p.kary;
+      ec.l.simple = {FLT_MAX, 1.f, 0.f};
+      base.multipredict(ec, n_child, count, p.node_preds.begin(), false);
+
+      for (size_t i = 0; i < count; ++i, ++n_child)
+      {
+        float cp_child = p.node_queue[first + i / p.kary].p * (1.f / (1.f + exp(-p.node_preds[i].scalar)));
+        if (n_child < p.ti) p.beam_next.push_back({n_child, cp_child});
+        else
+          p.beam_leaves.push_back({n_child, cp_child});
+      }
+      first = last;
+    }
+
+    if (p.beam_next.size() > p.beam_width)
+    {
+      std::nth_element(
+          p.beam_next.begin(), p.beam_next.begin() + p.beam_width, p.beam_next.end(), node_is_more_probable);
+      p.beam_next.resize(p.beam_width);
+    }
+    std::swap(p.node_queue, p.beam_next);
+  }
+
+  const size_t k = std::min<size_t>(p.top_k, p.beam_leaves.size());
+  std::partial_sort(p.beam_leaves.begin(), p.beam_leaves.begin() + k, p.beam_leaves.end(), node_is_more_probable);
+  for (size_t i = 0; i < k; ++i) labels.push_back(p.beam_leaves[i].n - p.ti);
+}
+
 template <bool threshold>
 void predict(plt& p, single_learner& base, example& ec)
 {
@@ -215,6 +312,10 @@ void predict(plt& p, single_learner& base, example& ec)
     }
   }
 
+  // top-k prediction with a beam
+  else if (p.beam_width > 0)
+    predict_top_k_beam(p, base, ec, preds.label_v);
+
   // top-k prediction
   else
   {
@@ -247,17 +348,18 @@ void predict(plt& p, single_learner& base, example& ec)
         if (preds.label_v.size() >= p.top_k) break;
       }
     }
+  }
 
-    // calculate p@
-    if (p.true_labels.size() > 0)
+  // calculate p@
+  if (!threshold && p.true_labels.size() > 0)
+  {
+    // a narrow beam can reach fewer than top_k leaves
+    for (size_t i = 0; i < preds.label_v.size(); ++i)
     {
-      for (size_t i = 0; i < p.top_k; ++i)
-      {
-        if (p.true_labels.count(preds.label_v[i])) ++p.tp_at[i];
-      }
-      ++p.ec_count;
-      p.true_count += static_cast<uint32_t>(p.true_labels.size());
+      if (p.true_labels.count(preds.label_v[i])) ++p.tp_at[i];
     }
+    ++p.ec_count;
+    p.true_count += static_cast<uint32_t>(p.true_labels.size());
   }
 
   p.node_queue.clear();
@@ -329,13 +431,27 @@ base_learner* plt_setup(options_i& options, vw& all)
                .help("predict labels with conditional marginal probability greater than <thr> threshold"))
       .add(make_option("top_k", tree->top_k)
                .default_value(0)
-               .help("predict top-<k> labels instead of labels above threshold"));
+               .help("predict top-<k> labels instead of labels above threshold"))
+      .add(make_option("plt_fused_learn", tree->fused_learn)
+               .help("learn the children of a node from one multipredict instead of predicting each of them. "
+                     "Nodes are updated in a different order, so the model can differ from the default one"))
+      .add(make_option("beam_width", tree->beam_width)
+               .default_value(0)
+               .help("keep only the <b> most probable nodes of each tree level in top-k prediction (0 = exact search)"));
   options.add_and_parse(new_options);
 
   if (!options.was_supplied("plt")) return nullptr;
 
   tree->all = &all;
 
+  // regularization changes the scale of every weight after each update, so siblings must be predicted one by one
+  if (tree->fused_learn && (all.reg_mode != 0 || all.audit))
+  {
+    tree->fused_learn = false;
+    if (!all.logger.quiet)
+      all.trace_message << "--plt_fused_learn is ignored with l1/l2 regularization and with audit" << std::endl;
+  }
+
   // calculate number of tree nodes
   const double a = std::pow(tree->kary, std::floor(std::log(tree->k) / std::log(tree->kary)));
   const double b = tree->k - a;
@@ -350,7 +466,11 @@ base_learner* plt_setup(options_i& options, vw& all)
     all.trace_message << "PLT k = " << tree->k << "\nkary_tree = " << tree->kary << std::endl;
     if (!all.training)
     {
-      if (tree->top_k > 0) { all.trace_message << "top_k = " << tree->top_k << std::endl; }
+      if (tree->top_k > 0)
+      {
+        all.trace_message << "top_k = " << tree->top_k << std::endl;
+        if (tree->beam_width > 0) all.trace_message << "beam_width = " << tree->beam_width << std::endl;
+      }
       else
       {
         all.trace_message << "threshold = " << tree->threshold << std::endl;
@@ -361,7 +481,7 @@ base_learner* plt_setup(options_i& options, vw& all)
   // resize v_arrays
   tree->nodes_time.resize(tree->t);
   std::fill(tree->nodes_time.begin(), tree->nodes_time.end(), all.initial_t);
-  tree->node_preds.resize(tree->kary);
+  tree->node_preds.resize(tree->kary * std::max<uint32_t>(tree->beam_width, 1));
   if (tree->top_k > 0) tree->tp_at.resize(tree->top_k);
 
   learner<plt, example>* l;
@@ -5,6 +5,9 @@
 #include <string.h>
 #include <math.h>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <exception>
 #include "vw.h"
 #include "rand48.h"
 #include "reductions.h"
@@ -17,6 +20,7 @@
 #include "search_hooktask.h"
 #include "search_graph.h"
 #include "search_meta.h"
+#include "search_prediction_cache.h"
 #include "csoaa.h"
 #include "active.h"
 #include "label_dictionary.h"
@@ -31,7 +35,6 @@ using std::endl;
 
 namespace Search
 {
-using byte_array = std::unique_ptr<uint8_t[]>;
 
 search_task* all_tasks[] = {&SequenceTask::task, &SequenceSpanTask::task, &SequenceTaskCostToGo::task,
     &ArgmaxTask::task, &SequenceTask_DemoLDF::task, &MulticlassTask::task, &DepParserTask::task,
@@ -49,7 +52,7 @@ std::string neighbor_feature_space("neighbor");
 std::string condition_feature_space("search_condition");
 
 uint32_t AUTO_CONDITION_FEATURES = 1, AUTO_HAMMING_LOSS = 2, EXAMPLES_DONT_CHANGE = 4, IS_LDF = 8, NO_CACHING = 16,
-         ACTION_COSTS = 32;
+         ACTION_COSTS = 32, STATE_COMPLETE_CONDITIONING = 64;
 enum SearchState
 {
   INITIALIZE,
@@ -87,15 +90,6 @@ struct auto_condition_settings
   bool use_passthrough_repr;     // should we ask lower-level reductions for their internal state?
 };
 
-struct scored_action
-{
-  action a;  // the action
-  float s;   // the predicted cost of this action
-  // v_array<feature> repr;
-  scored_action(action _a = (action)-1, float _s = 0) : a(_a), s(_s) {}  // , repr(v_init<feature>()) {}
-  // scored_action(action _a, float _s, v_array<feature>& _repr) : a(_a), s(_s), repr(_repr) {}
-  // scored_action() { a = (action)-1; s = 0.; }
-};
 std::ostream& operator<<(std::ostream& os, const scored_action& x)
 {
   os << x.a << ':' << x.s;
@@ -136,34 +130,25 @@ std::ostream& operator<<(std::ostream& os, const action_cache& x)
   return os;
 }
 
+// A partial action sequence kept on the beam, with the sum of the predicted costs of its actions.
+struct beam_hypothesis
+{
+  std::vector<scored_action> actions;
+  float cost;
+};
+// One way to extend a hypothesis by a step; order breaks ties between equal costs.
+struct beam_candidate
+{
+  float cost;
+  size_t hypothesis;
+  size_t order;
+  scored_action step;
+};
+
 void clear_memo_foreach_action(search_private& priv);
 
 struct search_private
 {
- private:
-  struct cached_item_equivalent
-  {
-    bool operator()(const byte_array& A, const byte_array& B) const
-    {
-      size_t sz_A = *A.get();
-      size_t sz_B = *B.get();
-      if (sz_A != sz_B)
-        return false;
-      return memcmp(A.get(), B.get(), sz_A) == 0;
-    }
-  };
-  struct cached_item_hash
-  {
-    size_t operator()(const byte_array& key) const
-    {
-      size_t sz = *key.get();
-      return uniform_hash(key.get(), sz, SEARCH_HASH_SEED);
-    }
-  };
-
- public:
-  using cache_map = std::unordered_map<byte_array, scored_action, cached_item_hash, cached_item_equivalent>;
-
   vw* all;
   std::shared_ptr<rand_state> _random_state;
 
@@ -205,6 +190,15 @@ struct search_private
   std::vector<action> test_action_sequence;  // if test-mode was run, what was the corresponding action sequence; it's a
                                              // vector cuz we might expose it to the library
   action learn_oracle_action;                // store an oracle action for debugging purposes
+
+  size_t beam_size;                                // --search_beam, how many hypotheses test-time decoding keeps
+  bool beam_expanding;                             // INIT_TEST runs score the actions after beam_prefix, then stop
+  const std::vector<scored_action>* beam_prefix;  // actions INIT_TEST replays before predicting, or nullptr
+  std::vector<scored_action> beam_scores;         // every action and its predicted cost after beam_prefix
+  std::vector<beam_hypothesis> beam;
+  std::vector<beam_hypothesis> next_beam;
+  std::vector<beam_hypothesis> beam_finished;
+  std::vector<beam_candidate> beam_candidates;
   features last_action_repr;
 
   polylabel* allowed_actions_cache;
@@ -262,7 +256,11 @@ struct search_private
   size_t total_predictions_made;
   size_t total_cache_hits;
 
-  cache_map cache_hash_map;
+  prediction_cache cache;
+  std::vector<uint8_t> cache_key;  // scratch space for serializing cache keys
+  bool cache_persists;             // the task declared STATE_COMPLETE_CONDITIONING, keep the cache for a whole pass
+  size_t cache_pass;               // the pass the cache was filled in
+  bool cache_size_supplied;        // --search_cache_size was given, report the cache statistics at the end
 
   // for foreach_feature temporary storage for conditioning
   uint64_t dat_new_feature_idx;
@@ -299,6 +297,19 @@ struct search_private
   v_array<v_array<action_cache>*>
       memo_foreach_action;  // when foreach_action is on, we need to cache TRAIN trajectory actions for LEARN
 
+  // for --search_rollout_threads: copies of this search, each with its own task data and example copies, that roll
+  // out the one-step deviations of a learn step concurrently
+  std::vector<std::unique_ptr<search>> rollout_workers;
+  bool rollout_examples_ready;             // the workers hold a set up copy of the current example sequence
+  v_array<size_t> train_valid_action_cnt;  // how many actions were valid at each step of train_trajectory
+  std::vector<float> rollout_losses;
+  std::mutex rollout_base_learner_lock;
+  // worker side
+  std::vector<example*> rollout_example_pool;
+  multi_ex rollout_examples;
+  const prediction_cache* shared_cache;  // the prediction cache of the search this one works for, read only
+  std::mutex* base_learner_lock;  // serializes predictions when the base learner is not thread safe
+
   ~search_private(){
     if(all)
     {
@@ -326,6 +337,7 @@ struct search_private
         allowed_actions_cache->cs.costs.delete_v();
 
       train_trajectory.delete_v();
+      train_valid_action_cnt.delete_v();
 
       for (auto& ar : ptag_to_action) delete ar.repr;
       ptag_to_action.delete_v();
@@ -1172,7 +1184,8 @@ action single_prediction_notLDF(search_private& priv, example& ec, int policy, c
   vw& all = *priv.all;
   polylabel old_label = ec.l;
   bool need_partial_predictions = need_memo_foreach_action(priv) ||
-      (priv.metaoverride && priv.metaoverride->_foreach_action) || (override_action != (action)-1) || priv.active_csoaa;
+      (priv.metaoverride && priv.metaoverride->_foreach_action) || (override_action != (action)-1) ||
+      priv.active_csoaa || priv.beam_expanding;
   if ((allowed_actions_cnt > 0) || need_partial_predictions)
     ec.l = allowed_actions_to_ld(priv, 1, allowed_actions, allowed_actions_cnt, allowed_actions_cost);
   else
@@ -1183,7 +1196,12 @@ action single_prediction_notLDF(search_private& priv, example& ec, int policy, c
     cdbg << ' ' << ec.l.cs.costs[i].class_index << ':' << ec.l.cs.costs[i].x;
   cdbg << " ]" << endl;
 
-  as_singleline(priv.base_learner)->predict(ec, policy);
+  {
+    std::unique_lock<std::mutex> lock;
+    if (priv.base_learner_lock)
+      lock = std::unique_lock<std::mutex>(*priv.base_learner_lock);
+    as_singleline(priv.base_learner)->predict(ec, policy);
+  }
 
   uint32_t act = ec.pred.multiclass;
   cdbg << "a=" << act << " from";
@@ -1224,6 +1242,8 @@ action single_prediction_notLDF(search_private& priv, example& ec, int policy, c
         a_cost = cost;
       if (this_cache)
         this_cache->push_back(action_cache(min_cost, cl, cl == act, cost));
+      if (priv.beam_expanding)
+        priv.beam_scores.push_back(scored_action(cl, cost));
     }
     if (this_cache)
     {
@@ -1347,7 +1367,12 @@ action single_prediction_LDF(search_private& priv, example* ecs, size_t ec_cnt,
     uint64_t old_offset = ecs[a].ft_offset;
     ecs[a].ft_offset = priv.offset;
     tmp.push_back(&ecs[a]);
-    as_multiline(priv.base_learner)->predict(tmp, policy);
+    {
+      std::unique_lock<std::mutex> lock;
+      if (priv.base_learner_lock)
+        lock = std::unique_lock<std::mutex>(*priv.base_learner_lock);
+      as_multiline(priv.base_learner)->predict(tmp, policy);
+    }
 
     ecs[a].ft_offset = old_offset;
     cdbg << "partial_prediction[" << a << "] = " << ecs[a].partial_prediction << endl;
@@ -1365,6 +1390,8 @@ action single_prediction_LDF(search_private& priv, example* ecs, size_t ec_cnt,
     }
     if (this_cache)
       this_cache->push_back(action_cache(0., a, false, ecs[a].partial_prediction));
+    if (priv.beam_expanding)
+      priv.beam_scores.push_back(scored_action(a, ecs[a].partial_prediction));
 
     priv.num_features += ecs[a].num_features;
     ecs[a].l = old_label;
@@ -1429,15 +1456,6 @@ int choose_policy(search_private& priv, bool advance_prng = true)
   }
 }
 
-bool cached_item_equivalent(unsigned char* const& A, unsigned char* const& B)
-{
-  size_t sz_A = *A;
-  size_t sz_B = *B;
-  if (sz_A != sz_B)
-    return false;
-  return memcmp(A, B, sz_A) == 0;
-}
-
 // returns true if found and do_store is false. if do_store is true, always returns true.
 bool cached_action_store_or_find(search_private& priv, ptag mytag, const ptag* condition_on,
     const char* condition_on_names, action_repr* condition_on_actions, size_t condition_on_cnt, int policy,
@@ -1452,11 +1470,12 @@ bool cached_action_store_or_find(search_private& priv, ptag mytag, const ptag* c
       condition_on_cnt * (sizeof(ptag) + sizeof(action) + sizeof(char));
   if (sz % 4 != 0)
     sz += 4 - (sz % 4);  // make sure sz aligns to 4 so that uniform_hash does the right thing
+  if (sz > UINT8_MAX)
+    return do_store;  // the size has to fit in the first byte of the key
 
-  byte_array item(new uint8_t[sz]);
-  uint8_t* here = item.get();
-  // get rid of a valgrind warning about uninitialized memory
-  memset(here, 0, sz);
+  priv.cache_key.assign(sz, 0);
+  uint8_t* item = priv.cache_key.data();
+  uint8_t* here = item;
   *here = (unsigned char)sz;
   here += sizeof(size_t);
   *here = static_cast<uint8_t>(mytag);
@@ -1476,17 +1495,23 @@ bool cached_action_store_or_find(search_private& priv, ptag mytag, const ptag* c
     *here = condition_on_names[i];
     here += sizeof(char);  // SPEEDUP: should we align this at 4?
   }
+  const uint64_t hash = uniform_hash(item, sz, SEARCH_HASH_SEED);
   if (do_store)
   {
-    priv.cache_hash_map.emplace(std::move(item), scored_action(a, a_cost));
+    priv.cache.insert(item, hash, scored_action(a, a_cost));
     return true;
   }
   else  // its a find
   {
-    auto sa_iter = priv.cache_hash_map.find(item);
-    if(sa_iter == priv.cache_hash_map.end()) return false;
-    a = sa_iter->second.a;
-    a_cost = sa_iter->second.s;
+    const scored_action* found = priv.shared_cache ? priv.shared_cache->find(item, hash) : nullptr;
+    if (found != nullptr)
+      priv.cache.hits++;
+    else
+      found = priv.cache.lookup(item, hash);
+    if (found == nullptr)
+      return false;
+    a = found->a;
+    a_cost = found->s;
     return a != (action)-1;
   }
 }
@@ -1610,6 +1635,10 @@ bool search_predictNeedsExample(search_private& priv)
     case GET_TRUTH_STRING:
       return false;
     case INIT_TEST:
+      // beam decoding replays the actions of a hypothesis and takes defaults after the step it scores
+      if (priv.beam_prefix && ((priv.t < priv.beam_prefix->size()) ||
+                                  (priv.beam_expanding && (priv.t > priv.beam_prefix->size()))))
+        return false;
       return true;
     case INIT_TRAIN:
       // TODO: do we need to do something here for metatasks?
@@ -1807,6 +1836,22 @@ action search_predict(search_private& priv, example* ecs, size_t ec_cnt, ptag my
     return a;
   }
 
+  // beam decoding replays a hypothesis, then predicts once to score the next step and takes defaults after it
+  if ((priv.state == INIT_TEST) && priv.beam_prefix)
+  {
+    if (t < priv.beam_prefix->size())
+    {
+      choose_policy(priv);  // draw from the generator like a greedy run does
+      a_cost = (*priv.beam_prefix)[t].s;
+      return (*priv.beam_prefix)[t].a;
+    }
+    if (priv.beam_expanding && (t > priv.beam_prefix->size()))
+    {
+      a_cost = 0.;
+      return priv.is_ldf ? 0 : ((allowed_actions && (allowed_actions_cnt > 0)) ? allowed_actions[0] : 1);
+    }
+  }
+
   if ((priv.state == INIT_TRAIN) || (priv.state == INIT_TEST) || ((priv.state == LEARN) && (t > priv.learn_t)))
   {
     // we actually need to run the policy
@@ -1850,7 +1895,7 @@ action search_predict(search_private& priv, example* ecs, size_t ec_cnt, ptag my
 
       bool not_test = priv.all->training && !ecs[0].test_only;
 
-      if ((!skip) && (!need_fea) && not_test &&
+      if ((!skip) && (!need_fea) && not_test && !priv.beam_expanding &&
           cached_action_store_or_find(priv, mytag, condition_on, condition_on_names, priv.condition_on_actions.begin(),
               condition_on_cnt, policy, learner_id, a, false, a_cost))
         // if this succeeded, 'a' has the right action
@@ -1932,7 +1977,10 @@ action search_predict(search_private& priv, example* ecs, size_t ec_cnt, ptag my
     }
 
     if (priv.state == INIT_TRAIN)
+    {
       priv.train_trajectory.push_back(scored_action(a, a_cost));  // note the action for future reference
+      priv.train_valid_action_cnt.push_back(valid_action_cnt);
+    }
 
     if (priv.metaoverride && priv.metaoverride->_post_prediction)
       priv.metaoverride->_post_prediction(*priv.metaoverride->sch, t - priv.meta_t, a, a_cost);
@@ -2173,6 +2221,191 @@ void advance_from_known_actions(search_private& priv)
   advance_from_known_actions(priv);
 }
 
+// Copies the example sequence into every rollout worker and runs the task setup on the copies, so that the workers
+// can run the task while this search keeps using the originals. This happens before the task setup of this search,
+// which may change the examples.
+void setup_rollout_examples(search_private& priv, multi_ex& ec_seq)
+{
+  vw& all = *priv.all;
+  for (auto& worker : priv.rollout_workers)
+  {
+    search_private& wp = *worker->priv;
+    while (wp.rollout_example_pool.size() < ec_seq.size())
+      wp.rollout_example_pool.push_back(VW::alloc_examples(sizeof(polylabel), 1));
+
+    wp.rollout_examples.clear();
+    for (size_t i = 0; i < ec_seq.size(); i++)
+    {
+      example* ec = wp.rollout_example_pool[i];
+      VW::copy_example_data(all.audit, ec, ec_seq[i], all.p->lp.label_size, all.p->lp.copy_label);
+      wp.rollout_examples.push_back(ec);
+    }
+
+    if (wp.task->run_setup)
+      wp.task->run_setup(*worker, wp.rollout_examples);
+    add_neighbor_features(wp, wp.rollout_examples);
+  }
+  priv.rollout_examples_ready = true;
+}
+
+void takedown_rollout_examples(search_private& priv)
+{
+  for (auto& worker : priv.rollout_workers)
+  {
+    search_private& wp = *worker->priv;
+    del_neighbor_features(wp, wp.rollout_examples);
+    if (wp.task->run_takedown)
+      wp.task->run_takedown(*worker, wp.rollout_examples);
+  }
+  priv.rollout_examples_ready = false;
+}
+
+// Brings a worker up to date with the state a LEARN run reads.
+void sync_rollout_worker(search_private& priv, search_private& wp)
+{
+  wp.offset = priv.offset;
+  wp.base_learner = priv.base_learner;
+  wp.read_example_last_id = priv.read_example_last_id;
+  wp.current_policy = priv.current_policy;
+  wp.beta = priv.beta;
+  wp.total_examples_generated = priv.total_examples_generated;
+  wp.force_oracle = priv.force_oracle;
+  copy_array(wp.train_trajectory, priv.train_trajectory);
+  wp.shared_cache = &priv.cache;
+  wp.total_predictions_made = 0;
+  wp.total_cache_hits = 0;
+  wp.cache.hits = wp.cache.misses = wp.cache.evictions = 0;
+  wp.num_calls_to_run = 0;
+}
+
+// Moves what a worker learned back: its statistics and the predictions it cached. Cached predictions are a function
+// of their key while the weights do not change, so the cache ends up as if the rollouts had run here.
+void merge_rollout_worker(search_private& priv, search_private& wp)
+{
+  priv.total_predictions_made += wp.total_predictions_made;
+  priv.total_cache_hits += wp.total_cache_hits;
+  priv.num_calls_to_run += wp.num_calls_to_run;
+  priv.cache.hits += wp.cache.hits;
+  priv.cache.misses += wp.cache.misses;
+  priv.cache.evictions += wp.cache.evictions;
+  wp.cache.for_each_entry([&priv](const uint8_t* key, uint64_t hash, const scored_action& value) {
+    priv.cache.insert(key, hash, value);
+  });
+  wp.cache.clear();
+  wp.shared_cache = nullptr;
+}
+
+// Rolls out all but the last one-step deviation at learn_t on the workers and records their losses in
+// priv.learn_losses, in action order. The last deviation is left to the caller: the run that reaches it is the one
+// that captures the examples and conditioning of the learn step for generate_training_example. Returns false when
+// there is not enough work to split, in which case nothing was done.
+bool run_parallel_rollouts(search& sch, size_t learn_t)
+{
+  search_private& priv = *sch.priv;
+  if (learn_t >= priv.train_valid_action_cnt.size())
+    return false;
+  const size_t num_rollouts = priv.train_valid_action_cnt[learn_t] - 1;
+  if (num_rollouts < 2)
+    return false;
+
+  const size_t num_workers = std::min(priv.rollout_workers.size(), num_rollouts);
+  priv.rollout_losses.resize(num_rollouts);
+  for (size_t w = 0; w < num_workers; w++) sync_rollout_worker(priv, *priv.rollout_workers[w]->priv);
+
+  std::vector<std::exception_ptr> errors(num_workers);
+  auto roll_out = [&priv, &errors, learn_t, num_rollouts, num_workers](size_t w) {
+    search& worker = *priv.rollout_workers[w];
+    search_private& wp = *worker.priv;
+    try
+    {
+      for (size_t a = w; a < num_rollouts; a += num_workers)
+      {
+        reset_search_structure(wp);
+        wp.state = LEARN;
+        wp.learn_t = learn_t;
+        wp.learn_a_idx = a;
+        run_task(worker, wp.rollout_examples);
+        priv.rollout_losses[a] = wp.learn_loss;
+      }
+    }
+    catch (...)
+    {
+      errors[w] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t w = 1; w < num_workers; w++) threads.emplace_back(roll_out, w);
+  roll_out(0);
+  for (auto& thread : threads) thread.join();
+
+  for (size_t w = 0; w < num_workers; w++) merge_rollout_worker(priv, *priv.rollout_workers[w]->priv);
+  for (auto& error : errors)
+    if (error)
+      std::rethrow_exception(error);
+
+  for (size_t a = 0; a < num_rollouts; a++)
+    cs_cost_push_back(priv.cb_learner, priv.learn_losses, priv.is_ldf ? (uint32_t)a : (uint32_t)(a + 1),
+        priv.rollout_losses[a]);
+  priv.learn_a_idx = num_rollouts;
+  return true;
+}
+
+// Expands priv.beam_size hypotheses at a time to find the action sequence of ec_seq with the smallest total predicted
+// cost, and leaves it in priv.beam_prefix for the INIT_TEST run that follows. Each step runs the task once per
+// hypothesis: the run replays the hypothesis, scores every action of the next step with one prediction and takes
+// default actions after that. A hypothesis whose run ends before its next step is complete.
+// Decoding a sequence of T steps thus makes T * B base predictions but runs the task T * B times over the whole
+// sequence, O(T^2 * B) task steps, since the task owns its control flow and cannot be resumed from a saved state.
+// predictNeedsExample is false for the replayed and default steps, so tasks skip building their examples there and
+// only the scored step of each run pays for features.
+void beam_decode(search& sch, multi_ex& ec_seq)
+{
+  search_private& priv = *sch.priv;
+  priv.beam.resize(1);
+  priv.beam[0].actions.clear();
+  priv.beam[0].cost = 0.;
+  priv.beam_finished.clear();
+  priv.beam_expanding = true;
+  while (!priv.beam.empty())
+  {
+    priv.beam_candidates.clear();
+    for (size_t h = 0; h < priv.beam.size(); h++)
+    {
+      reset_search_structure(priv);
+      priv.state = INIT_TEST;
+      priv.beam_prefix = &priv.beam[h].actions;
+      priv.beam_scores.clear();
+      run_task(sch, ec_seq);
+      if (priv.beam_scores.empty())
+        priv.beam_finished.push_back(priv.beam[h]);
+      for (const scored_action& sa : priv.beam_scores)
+        priv.beam_candidates.push_back({priv.beam[h].cost + sa.s, h, priv.beam_candidates.size(), sa});
+    }
+
+    const size_t keep = std::min(priv.beam_size, priv.beam_candidates.size());
+    std::partial_sort(priv.beam_candidates.begin(), priv.beam_candidates.begin() + keep, priv.beam_candidates.end(),
+        [](const beam_candidate& a, const beam_candidate& b) {
+          return (a.cost < b.cost) || ((a.cost == b.cost) && (a.order < b.order));
+        });
+    priv.next_beam.resize(keep);
+    for (size_t i = 0; i < keep; i++)
+    {
+      const beam_candidate& c = priv.beam_candidates[i];
+      priv.next_beam[i].actions = priv.beam[c.hypothesis].actions;
+      priv.next_beam[i].actions.push_back(c.step);
+      priv.next_beam[i].cost = c.cost;
+    }
+    std::swap(priv.beam, priv.next_beam);
+  }
+  priv.beam_expanding = false;
+
+  size_t best = 0;
+  for (size_t i = 1; i < priv.beam_finished.size(); i++)
+    if (priv.beam_finished[i].cost < priv.beam_finished[best].cost)
+      best = i;
+  priv.beam_prefix = priv.beam_finished.empty() ? nullptr : &priv.beam_finished[best].actions;
+}
+
 template <bool is_learn>
 void train_single_example(search& sch, bool is_test_ex, bool is_holdout_ex, multi_ex& ec_seq)
 {
@@ -2180,8 +2413,12 @@ void train_single_example(search& sch, bool is_test_ex, bool is_holdout_ex, mult
   vw& all = *priv.all;
   bool ran_test = false;  // we must keep track so that even if we skip test, we still update # of examples seen
 
-  // if (! priv.no_caching)
-  priv.cache_hash_map.clear();
+  // with state complete conditioning the cached predictions stay valid for the rest of the pass
+  if (!priv.cache_persists || priv.cache_pass != priv.read_example_last_pass)
+  {
+    priv.cache.clear();
+    priv.cache_pass = priv.read_example_last_pass;
+  }
 
   cdbg << "is_test_ex=" << is_test_ex << " vw_is_main=" << all.vw_is_main << endl;
   cdbg << "must_run_test = " << must_run_test(all, ec_seq, is_test_ex) << endl;
@@ -2193,6 +2430,11 @@ void train_single_example(search& sch, bool is_test_ex, bool is_holdout_ex, mult
 
     ran_test = true;
 
+    // examples that are not learned from are decoded with the beam, if there is one
+    if ((priv.beam_size > 1) &&
+        (!is_learn || is_test_ex || is_holdout_ex || ec_seq[0]->test_only || !priv.all->training))
+      beam_decode(sch, ec_seq);
+
     // do the prediction
     reset_search_structure(priv);
     priv.state = INIT_TEST;
@@ -2201,6 +2443,7 @@ void train_single_example(search& sch, bool is_test_ex, bool is_holdout_ex, mult
     priv.pred_string->str("");
     priv.test_action_sequence.clear();
     run_task(sch, ec_seq);
+    priv.beam_prefix = nullptr;
 
     // accumulate loss
     if (!is_test_ex)
@@ -2227,12 +2470,14 @@ void train_single_example(search& sch, bool is_test_ex, bool is_holdout_ex, mult
        << priv.read_example_last_pass << ") ========================================" << endl;
   // std::cerr << "training" << endl;
 
-  priv.cache_hash_map.clear();
+  if (!priv.cache_persists)
+    priv.cache.clear();
   reset_search_structure(priv);
   clear_memo_foreach_action(priv);
   priv.state = INIT_TRAIN;
   priv.active_uncertainty.clear();
   priv.train_trajectory.clear();  // this is where we'll store the training sequence
+  priv.train_valid_action_cnt.clear();
   run_task(sch, ec_seq);
 
   if (!ran_test)  // was  && !priv.ec_seq[0]->test_only) { but we know it's not test_only
@@ -2285,6 +2530,8 @@ void train_single_example(search& sch, bool is_test_ex, bool is_holdout_ex, mult
     bool skipped_all_actions = true;
     priv.learn_a_idx = 0;
     priv.done_with_all_actions = false;
+    if (priv.rollout_examples_ready && run_parallel_rollouts(sch, priv.timesteps[tid]))
+      skipped_all_actions = false;
     // for each action, roll out to get a loss
     while (!priv.done_with_all_actions)
     {
@@ -2411,6 +2658,14 @@ void do_actual_learning(search& sch, base_learner& base, multi_ex& ec_seq)
       break;
   }
 
+  // the workers copy the examples before the task setup below gets to them
+  bool parallel_rollouts = !priv.rollout_workers.empty() && is_learn && !is_test_ex && !is_holdout_ex &&
+      !ec_seq[0]->test_only && priv.all->training;
+  if (priv.rollout_examples_ready)
+    takedown_rollout_examples(priv);
+  if (parallel_rollouts)
+    setup_rollout_examples(priv, ec_seq);
+
   if (priv.task->run_setup)
     priv.task->run_setup(sch, ec_seq);
 
@@ -2434,6 +2689,8 @@ void do_actual_learning(search& sch, base_learner& base, multi_ex& ec_seq)
   add_neighbor_features(priv, ec_seq);
   train_single_example<is_learn>(sch, is_test_ex, is_holdout_ex, ec_seq);
   del_neighbor_features(priv, ec_seq);
+  if (priv.rollout_examples_ready)
+    takedown_rollout_examples(priv);
 
   if (priv.task->run_takedown)
     priv.task->run_takedown(sch, ec_seq);
@@ -2522,10 +2779,6 @@ void search_initialize(vw* all, search& sch)
 
   priv.acset.feature_value = 1.;
 
-  scored_action sa((action)-1, 0.);
-  // unnecessary if priv has a proper constructor
-  new (&priv.cache_hash_map) search_private::cache_map();
-
   sch.task_data = nullptr;
 
   priv.active_uncertainty.clear();
@@ -2539,6 +2792,55 @@ void search_initialize(vw* all, search& sch)
   new (&priv.dat_new_feature_audit_ss) std::stringstream();
 }
 
+// Creates the searches that run rollouts for --search_rollout_threads. Each one runs the task initialization again,
+// which gives it task data of its own; the options it parses are the ones this search was set up with.
+void add_rollout_workers(search& sch, size_t num_actions, options_i& options, size_t num_workers)
+{
+  search_private& priv = *sch.priv;
+  // most base learners keep scratch state in their data, the workers take turns predicting with those
+  std::mutex* base_learner_lock =
+      CSOAA::predict_is_thread_safe(*priv.all) ? nullptr : &priv.rollout_base_learner_lock;
+  for (size_t w = 0; w < num_workers; w++)
+  {
+    priv.rollout_workers.emplace_back(new search());
+    search& worker = *priv.rollout_workers.back();
+    search_private& wp = *worker.priv;
+    search_initialize(priv.all, worker);
+    // rollouts reseed the generator they use, a private one keeps them from racing on the shared one
+    wp._random_state = std::make_shared<rand_state>();
+    wp.task = priv.task;
+    worker.task_name = sch.task_name;
+    wp.A = num_actions;
+    wp.rollout_method = priv.rollout_method;
+    wp.cb_learner = false;
+    wp.allowed_actions_cache = &calloc_or_throw<polylabel>();
+    CS::cs_label.default_label(wp.allowed_actions_cache);
+    wp.learn_losses.cs.costs = v_init<CS::wclass>();
+    wp.gte_label.cs.costs = v_init<CS::wclass>();
+    if (wp.task->initialize)
+      wp.task->initialize(worker, wp.A, options);
+
+    wp.A = priv.A;
+    wp.num_learners = priv.num_learners;
+    wp.no_caching = priv.no_caching;
+    wp.cache.set_capacity(priv.cache.capacity());
+    wp.acset = priv.acset;
+    wp.history_length = priv.history_length;
+    copy_array(wp.neighbor_features, priv.neighbor_features);
+    wp.rollin_method = priv.rollin_method;
+    wp.rollout_num_steps = priv.rollout_num_steps;
+    wp.alpha = priv.alpha;
+    wp.adaptive_beta = priv.adaptive_beta;
+    wp.allow_current_policy = priv.allow_current_policy;
+    wp.passes_per_policy = priv.passes_per_policy;
+    wp.total_number_of_policies = priv.total_number_of_policies;
+    wp.xv = priv.xv;
+    wp.perturb_oracle = priv.perturb_oracle;
+    wp.subsample_timesteps = priv.subsample_timesteps;
+    wp.base_learner_lock = base_learner_lock;
+  }
+}
+
 void ensure_param(float& v, float lo, float hi, float def, const char* str)
 {
   if ((v < lo) || (v > hi))
@@ -2577,11 +2879,29 @@ void search_finish(search& sch)
 
   if (priv.active_csoaa)
     std::cerr << "search calls to run = " << priv.num_calls_to_run << endl;
+  // only reported when the cache is configured or had to evict, so the default output stays as it was
+  const bool report_cache = priv.cache_size_supplied || priv.cache_persists || priv.cache.evictions > 0;
+  if (!priv.no_caching && report_cache && !priv.all->logger.quiet)
+    std::cerr << "search cache hits = " << priv.cache.hits << ", misses = " << priv.cache.misses
+              << ", evictions = " << priv.cache.evictions << endl;
 
   if (priv.task->finish)
     priv.task->finish(sch);
   if (priv.metatask && priv.metatask->finish)
     priv.metatask->finish(sch);
+
+  for (auto& worker : priv.rollout_workers)
+  {
+    search_private& wp = *worker->priv;
+    for (example* ec : wp.rollout_example_pool)
+    {
+      VW::dealloc_example(priv.all->p->lp.delete_label, *ec);
+      free(ec);
+    }
+    wp.rollout_example_pool.clear();
+    if (wp.task->finish)
+      wp.task->finish(*worker);
+  }
 }
 
 v_array<CS::label> read_allowed_transitions(action A, const char* filename)
@@ -2686,6 +3006,8 @@ base_learner* setup(options_i& options, vw& all)
 
   uint32_t search_trained_nb_policies;
   std::string search_allowed_transitions;
+  uint64_t rollout_threads;
+  uint64_t cache_size;
 
   priv.A = 1;
   option_group_definition new_options("Search options");
@@ -2737,8 +3059,16 @@ base_learner* setup(options_i& options, vw& all)
                       .keep()
                       .default_value(1)
                       .help("some tasks allow you to specify how much history their depend on; specify that here"));
+  new_options.add(make_option("search_beam", priv.beam_size)
+                      .default_value(1)
+                      .help("number of hypotheses kept when decoding examples that are not learned from (def: 1, "
+                            "greedy). Each step replays the task once per hypothesis, so decoding T steps with B "
+                            "hypotheses takes O(T^2 * B) task steps, of which only T * B build an example"));
   new_options.add(make_option("search_no_caching", priv.no_caching)
                       .help("turn off the built-in caching ability (makes things slower, but technically more safe)"));
+  new_options.add(make_option("search_cache_size", cache_size)
+                      .default_value(65536)
+                      .help("number of predictions the built-in cache holds before it evicts the least recently used"));
   new_options.add(
       make_option("search_xv", priv.xv).help("train two separate policies, alternating prediction/learning"));
   new_options.add(make_option("search_perturb_oracle", priv.perturb_oracle)
@@ -2750,6 +3080,9 @@ base_learner* setup(options_i& options, vw& all)
                       .help("verify that active learning is doing the right thing (arg = multiplier, should be = "
                             "cost_range * range_c)"));
   new_options.add(make_option("search_save_every_k_runs", priv.save_every_k_runs).help("save model every k runs"));
+  new_options.add(make_option("search_rollout_threads", rollout_threads)
+                      .default_value(1)
+                      .help("number of threads running the rollouts of a learning step concurrently (def: 1)"));
   options.add_and_parse(new_options);
 
   if (!options.was_supplied("search_task"))
@@ -2892,6 +3225,10 @@ base_learner* setup(options_i& options, vw& all)
       sch->metatask_name = (*mytask)->metatask_name;
       break;
     }
+  if (priv.beam_size == 0)
+    THROW("error: --search_beam must be at least 1");
+  if ((priv.beam_size > 1) && priv.metatask)
+    THROW("error: --search_beam cannot be combined with --search_metatask");
   all.p->emptylines_separate_examples = true;
 
   if (!options.was_supplied("csoaa") && !options.was_supplied("cs_active") && !options.was_supplied("csoaa_ldf") &&
@@ -2913,6 +3250,7 @@ base_learner* setup(options_i& options, vw& all)
   // default to OAA labels unless the task wants to override this (which they can do in initialize)
   all.p->lp = MC::mc_label;
   all.label_type = label_type_t::mc;
+  const size_t num_actions = priv.A;
   if (priv.task && priv.task->initialize)
     priv.task->initialize(*sch.get(), priv.A, options);
   if (priv.metatask && priv.metatask->initialize)
@@ -2937,6 +3275,24 @@ base_learner* setup(options_i& options, vw& all)
 
   cdbg << "num_learners = " << priv.num_learners << endl;
 
+  if (cache_size == 0 || cache_size > UINT32_MAX)
+    THROW("error: --search_cache_size must be between 1 and " << UINT32_MAX);
+  priv.cache.set_capacity(cache_size);
+  priv.cache_size_supplied = options.was_supplied("search_cache_size");
+
+  if (rollout_threads == 0)
+    THROW("error: --search_rollout_threads must be at least 1");
+  if (rollout_threads > 1)
+  {
+    // rollouts are only independent of each other when each one reseeds the generator and nothing but the task
+    // data carries state between runs
+    if (priv.rollout_method == NO_ROLLOUT || priv.cb_learner || priv.metatask || priv.active_csoaa ||
+        priv.task == &HookTask::task || !all.training)
+      std::cerr << "warning: --search_rollout_threads has no effect with this search configuration" << endl;
+    else
+      add_rollout_workers(*sch.get(), num_actions, options, rollout_threads);
+  }
+
   learner<search, multi_ex>& l = init_learner(sch, make_base(*base), do_actual_learning<true>,
       do_actual_learning<false>, priv.total_number_of_policies * priv.num_learners);
   l.set_finish_example(finish_multiline_example);
@@ -3033,7 +3389,9 @@ action search::predictLDF(example* ecs, size_t ec_cnt, ptag mytag, const action*
         priv->ptag_to_action[mytag].repr = nullptr;
       }
     }
-    push_at(priv->ptag_to_action, action_repr(ecs[a].l.cs.costs[0].class_index, &(priv->last_action_repr)), mytag);
+    // the representation is only read back when conditioning on it, copying it costs an allocation per prediction
+    features* repr = priv->acset.use_passthrough_repr ? &(priv->last_action_repr) : nullptr;
+    push_at(priv->ptag_to_action, action_repr(ecs[a].l.cs.costs[0].class_index, repr), mytag);
   }
   if (priv->auto_hamming_loss)
     loss(action_hamming_loss(a, oracle_actions, oracle_actions_cnt));  // TODO: action costs
@@ -3071,6 +3429,8 @@ void search::set_options(uint32_t opts)
     this->priv->no_caching = true;
   if ((opts & ACTION_COSTS) != 0)
     this->priv->use_action_costs = true;
+  if ((opts & STATE_COMPLETE_CONDITIONING) != 0)
+    this->priv->cache_persists = true;
 
   if (this->priv->is_ldf && this->priv->use_action_costs)
     THROW("using LDF and actions costs is not yet implemented; turn off action costs");  // TODO fix
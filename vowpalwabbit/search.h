@@ -22,7 +22,8 @@ namespace Search
 struct search_private;
 struct search_task;
 
-extern uint32_t AUTO_CONDITION_FEATURES, AUTO_HAMMING_LOSS, EXAMPLES_DONT_CHANGE, IS_LDF, NO_CACHING, ACTION_COSTS;
+extern uint32_t AUTO_CONDITION_FEATURES, AUTO_HAMMING_LOSS, EXAMPLES_DONT_CHANGE, IS_LDF, NO_CACHING, ACTION_COSTS,
+    STATE_COMPLETE_CONDITIONING;
 
 struct search;
 
@@ -103,6 +104,9 @@ struct search
 
   // for setting programmatic options during initialization
   // this should be an or ("|") of AUTO_CONDITION_FEATURES, etc.
+  // STATE_COMPLETE_CONDITIONING declares that the tag and what a prediction
+  // conditions on determine its features across examples, not only within
+  // one; cached predictions are then kept for the whole pass.
   void set_options(uint32_t opts);
 
   // change the default label parser, but you _must_ tell me how
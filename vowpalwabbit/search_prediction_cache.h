@@ -0,0 +1,192 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "search.h"
+
+namespace Search
+{
+struct scored_action
+{
+  action a;  // the action
+  float s;   // the predicted cost of this action
+  // v_array<feature> repr;
+  scored_action(action _a = (action)-1, float _s = 0) : a(_a), s(_s) {}  // , repr(v_init<feature>()) {}
+  // scored_action(action _a, float _s, v_array<feature>& _repr) : a(_a), s(_s), repr(_repr) {}
+  // scored_action() { a = (action)-1; s = 0.; }
+};
+
+// Maps the serialized conditioning of a prediction (a key whose first byte is its length) to the prediction. The
+// number of entries is bounded: entries come from a pool that is reused once it is full, keys are hashed once by the
+// caller, and the entry to evict is chosen with the CLOCK approximation of LRU. Clearing is constant time.
+class prediction_cache
+{
+ public:
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
+
+  void set_capacity(size_t capacity)
+  {
+    _capacity = std::max<size_t>(capacity, 1);
+    clear();
+  }
+  size_t capacity() const { return _capacity; }
+  size_t size() const { return _size; }
+
+  void clear()
+  {
+    _size = 0;
+    _hand = 0;
+    if (++_generation == 0)  // the stamps of the slots would become ambiguous, start over
+    {
+      std::fill(_slots.begin(), _slots.end(), slot());
+      _generation = 1;
+    }
+  }
+
+  // Lookup that leaves the cache untouched, so several threads may read at once.
+  const scored_action* find(const uint8_t* key, uint64_t hash) const
+  {
+    const size_t pos = find_slot(key, hash);
+    return pos == NOT_FOUND ? nullptr : &_entries[_slots[pos].entry].value;
+  }
+
+  // Lookup that counts a hit or miss and protects the entry from the next eviction.
+  const scored_action* lookup(const uint8_t* key, uint64_t hash)
+  {
+    const size_t pos = find_slot(key, hash);
+    if (pos == NOT_FOUND)
+    {
+      misses++;
+      return nullptr;
+    }
+    hits++;
+    entry& e = _entries[_slots[pos].entry];
+    e.referenced = true;
+    return &e.value;
+  }
+
+  // Adds the prediction unless the key is already cached, in which case the first prediction is kept.
+  void insert(const uint8_t* key, uint64_t hash, const scored_action& value)
+  {
+    if (find_slot(key, hash) != NOT_FOUND)
+      return;
+
+    uint32_t index;
+    if (_size < _capacity)
+    {
+      index = (uint32_t)_size++;
+      if (index == _entries.size())
+        _entries.emplace_back();
+      if (_size * 2 > _slots.size())
+        grow();
+    }
+    else
+    {
+      while (_entries[_hand].referenced)
+      {
+        _entries[_hand].referenced = false;
+        _hand = (_hand + 1) % _size;
+      }
+      index = (uint32_t)_hand;
+      _hand = (_hand + 1) % _size;
+      erase_slot(find_slot(_entries[index].key.data(), _entries[index].hash));
+      evictions++;
+    }
+
+    entry& e = _entries[index];
+    e.key.assign(key, key + *key);
+    e.hash = hash;
+    e.value = value;
+    e.referenced = false;
+    place(index);
+  }
+
+  template <class F>
+  void for_each_entry(F f) const
+  {
+    for (size_t i = 0; i < _size; i++) f(_entries[i].key.data(), _entries[i].hash, _entries[i].value);
+  }
+
+ private:
+  struct entry
+  {
+    std::vector<uint8_t> key;  // keeps its storage when the entry is reused
+    uint64_t hash = 0;
+    scored_action value;
+    bool referenced = false;
+  };
+  // An open addressing index into the entries. A slot is in use when it carries the current generation.
+  struct slot
+  {
+    uint32_t entry = 0;
+    uint32_t generation = 0;
+  };
+  static constexpr size_t NOT_FOUND = (size_t)-1;
+
+  std::vector<entry> _entries;
+  std::vector<slot> _slots;
+  size_t _capacity = 1;
+  size_t _size = 0;
+  size_t _hand = 0;
+  uint32_t _generation = 1;
+
+  bool used(size_t pos) const { return _slots[pos].generation == _generation; }
+  size_t mask() const { return _slots.size() - 1; }
+
+  size_t find_slot(const uint8_t* key, uint64_t hash) const
+  {
+    if (_slots.empty())
+      return NOT_FOUND;
+    for (size_t pos = hash & mask(); used(pos); pos = (pos + 1) & mask())
+    {
+      const entry& e = _entries[_slots[pos].entry];
+      if (e.hash == hash && e.key[0] == key[0] && memcmp(e.key.data(), key, key[0]) == 0)
+        return pos;
+    }
+    return NOT_FOUND;
+  }
+
+  void place(uint32_t index)
+  {
+    size_t pos = _entries[index].hash & mask();
+    while (used(pos)) pos = (pos + 1) & mask();
+    _slots[pos].entry = index;
+    _slots[pos].generation = _generation;
+  }
+
+  // Removes a slot, moving later slots of its probe sequence back so that no lookup stops early.
+  void erase_slot(size_t pos)
+  {
+    size_t next = (pos + 1) & mask();
+    while (used(next))
+    {
+      const size_t home = _entries[_slots[next].entry].hash & mask();
+      // the entry in next may move to pos unless its home lies cyclically in (pos, next]
+      if (((next - home) & mask()) >= ((next - pos) & mask()))
+      {
+        _slots[pos] = _slots[next];
+        pos = next;
+      }
+      next = (next + 1) & mask();
+    }
+    _slots[pos].generation = _generation - 1;
+  }
+
+  void grow()
+  {
+    size_t new_size = std::max<size_t>(_slots.size() * 2, 64);
+    _slots.assign(new_size, slot());
+    _generation = 1;
+    for (uint32_t i = 0; i < _size - 1; i++) place(i);  // the entry being inserted is placed by the caller
+  }
+};
+}  // namespace Search
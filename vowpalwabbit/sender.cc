@@ -3,6 +3,8 @@
 // license as described in the file LICENSE.
 
 #include <vector>
+#include <deque>
+#include <algorithm>
 #ifdef _WIN32
 #define NOMINMAX
 #include <WinSock2.h>
@@ -17,40 +19,74 @@
 #ifndef SHUT_RDWR
 #define SHUT_RDWR SD_BOTH
 #endif
+#define poll WSAPoll
 #else
 #include <netdb.h>
+#include <poll.h>
+#include <csignal>
 #endif
 
 #include "io_buf.h"
 #include "cache.h"
 #include "network.h"
 #include "reductions.h"
+#include "vw_exception.h"
 
 using namespace VW::config;
 
-struct sender
+// One prediction server. Each server answers its examples in the order they were sent.
+struct sender_connection
 {
+  std::string host;
+  int fd;
   io_buf* buf;
   std::unique_ptr<VW::io::socket> _socket;
   std::unique_ptr<VW::io::reader> _socket_reader;
+  size_t in_flight;  // sent, result not yet consumed
+  size_t unflushed;  // written to buf since the last flush
+  std::deque<float> results;  // read ahead of the examples they belong to
+
+  ~sender_connection() { delete buf; }
+};
+
+struct sender
+{
+  std::vector<std::unique_ptr<sender_connection>> connections;
   vw* all;  // loss ring_size others
   example** delay_ring;
+  size_t* delay_ring_connection;  // the connection each example in delay_ring was sent to
   size_t sent_index;
   size_t received_index;
+  size_t window;      // maximum examples in flight per connection
+  size_t batch_size;  // examples written to a connection before it is flushed
+  size_t next_connection;
 
   ~sender()
   {
     free(delay_ring);
-    delete buf;
+    free(delay_ring_connection);
   }
 };
 
-void open_sockets(sender& s, std::string host)
+void open_sockets(sender& s, const std::vector<std::string>& hosts)
 {
-  s._socket = VW::io::wrap_socket_descriptor(open_socket(host.c_str()));
-  s._socket_reader = s._socket->get_reader();
-  s.buf = new io_buf();
-  s.buf->add_file(s._socket->get_writer());
+#ifndef _WIN32
+  // a server that went away must surface as an error on its connection instead of killing us with SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  for (const auto& host : hosts)
+  {
+    auto c = VW::make_unique<sender_connection>();
+    c->host = host;
+    c->fd = open_socket(host.c_str());
+    c->_socket = VW::io::wrap_socket_descriptor(c->fd);
+    c->_socket_reader = c->_socket->get_reader();
+    c->buf = new io_buf();
+    c->buf->add_file(c->_socket->get_writer());
+    c->in_flight = 0;
+    c->unflushed = 0;
+    s.connections.push_back(std::move(c));
+  }
 }
 
 void send_features(io_buf* b, example& ec, uint32_t mask)
@@ -64,16 +100,74 @@ void send_features(io_buf* b, example& ec, uint32_t mask)
       continue;
     output_features(*b, ns, ec.feature_space[ns], mask);
   }
-  b->flush();
 }
 
-void receive_result(sender& s)
+void flush(sender_connection& c)
+{
+  if (c.unflushed > 0)
+  {
+    c.buf->flush();
+    c.unflushed = 0;
+  }
+}
+
+void connection_closed(sender_connection& c)
+{
+  THROW("--sendto " << c.host << " closed the connection with " << c.in_flight - c.results.size()
+                    << " example(s) awaiting a prediction");
+}
+
+void read_result(sender_connection& c)
 {
   float res, weight;
+  if (!get_prediction(c._socket_reader.get(), res, weight))
+    connection_closed(c);
+  c.results.push_back(res);
+}
 
-  get_prediction(s._socket_reader.get(), res, weight);
-  example& ec = *s.delay_ring[s.received_index++ % s.all->p->ring_size];
-  ec.pred.scalar = res;
+// Reads the results that have already arrived on any connection without blocking.
+void read_available_results(sender& s)
+{
+  std::vector<pollfd> fds;
+  std::vector<size_t> owners;
+  for (size_t i = 0; i < s.connections.size(); i++)
+    if (s.connections[i]->results.size() < s.connections[i]->in_flight)
+    {
+      fds.push_back({s.connections[i]->fd, POLLIN, 0});
+      owners.push_back(i);
+    }
+
+  while (!fds.empty() && poll(fds.data(), (unsigned long)fds.size(), 0) > 0)
+  {
+    for (size_t i = 0; i < fds.size(); i++)
+    {
+      sender_connection& c = *s.connections[owners[i]];
+      // a closed or failed connection may still hold results, so drain what is readable first
+      if (fds[i].revents & POLLIN)
+        read_result(c);
+      else if (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL))
+        connection_closed(c);
+      if (c.results.size() == c.in_flight)
+        fds[i].fd = -1;  // nothing more to expect, poll ignores negative descriptors
+    }
+  }
+}
+
+// Finishes the oldest outstanding example, waiting for its result if it has not arrived yet.
+void receive_result(sender& s)
+{
+  size_t slot = s.received_index++ % s.all->p->ring_size;
+  sender_connection& c = *s.connections[s.delay_ring_connection[slot]];
+  if (c.results.empty())
+  {
+    flush(c);
+    read_result(c);
+  }
+
+  example& ec = *s.delay_ring[slot];
+  ec.pred.scalar = c.results.front();
+  c.results.pop_front();
+  c.in_flight--;
 
   label_data& ld = ec.l.simple;
   ec.loss = s.all->loss->getLoss(s.all->sd, ec.pred.scalar, ld.label) * ec.weight;
@@ -81,33 +175,77 @@ void receive_result(sender& s)
   return_simple_example(*(s.all), nullptr, ec);
 }
 
+// Picks the connection with the fewest examples in flight, rotating between equally loaded ones.
+// Returns false if every connection has a full window.
+bool pick_connection(sender& s, size_t& picked)
+{
+  bool found = false;
+  for (size_t k = 0; k < s.connections.size(); k++)
+  {
+    size_t i = (s.next_connection + k) % s.connections.size();
+    size_t load = s.connections[i]->in_flight;
+    if (load < s.window && (!found || load < s.connections[picked]->in_flight))
+    {
+      picked = i;
+      found = true;
+    }
+  }
+  if (found)
+    s.next_connection = (picked + 1) % s.connections.size();
+  return found;
+}
+
 void learn(sender& s, VW::LEARNER::single_learner&, example& ec)
 {
+  read_available_results(s);
+  // finish whatever is ready so that output keeps up with input
+  while (s.received_index != s.sent_index &&
+      !s.connections[s.delay_ring_connection[s.received_index % s.all->p->ring_size]]->results.empty())
+    receive_result(s);
+
   if (s.received_index + s.all->p->ring_size / 2 - 1 == s.sent_index)
     receive_result(s);
 
+  size_t picked = 0;
+  while (!pick_connection(s, picked)) receive_result(s);
+  sender_connection& c = *s.connections[picked];
+
   s.all->set_minmax(s.all->sd, ec.l.simple.label);
-  s.all->p->lp.cache_label(&ec.l, *s.buf);  // send label information.
-  cache_tag(*s.buf, ec.tag);
-  send_features(s.buf, ec, (uint32_t)s.all->parse_mask);
-  s.delay_ring[s.sent_index++ % s.all->p->ring_size] = &ec;
+  s.all->p->lp.cache_label(&ec.l, *c.buf);  // send label information.
+  cache_tag(*c.buf, ec.tag);
+  send_features(c.buf, ec, (uint32_t)s.all->parse_mask);
+  c.in_flight++;
+  if (++c.unflushed >= s.batch_size)
+    flush(c);
+
+  size_t slot = s.sent_index++ % s.all->p->ring_size;
+  s.delay_ring[slot] = &ec;
+  s.delay_ring_connection[slot] = picked;
 }
 
 void finish_example(vw&, sender&, example&) {}
 
 void end_examples(sender& s)
 {
+  for (auto& c : s.connections) flush(*c);
   // close our outputs to signal finishing.
   while (s.received_index != s.sent_index) receive_result(s);
-  s.buf->close_files();
+  for (auto& c : s.connections) c->buf->close_files();
 }
 
 VW::LEARNER::base_learner* sender_setup(options_i& options, vw& all)
 {
-  std::string host;
+  std::vector<std::string> hosts;
+  size_t window = 0;
+  size_t batch_size = 1;
 
   option_group_definition sender_options("Network sending");
-  sender_options.add(make_option("sendto", host).keep().help("send examples to <host>"));
+  sender_options.add(make_option("sendto", hosts).keep().help("send examples to <host>, may be given several times"))
+      .add(make_option("sendto_window", window)
+               .help("maximum examples awaiting a prediction per host (default: share the example ring evenly)"))
+      .add(make_option("sendto_batch", batch_size)
+               .default_value(1)
+               .help("number of examples written to a host before they are flushed to the network"));
   options.add_and_parse(sender_options);
 
   if (!options.was_supplied("sendto"))
@@ -116,10 +254,13 @@ VW::LEARNER::base_learner* sender_setup(options_i& options, vw& all)
   }
 
   auto s = scoped_calloc_or_throw<sender>();
-  open_sockets(*s.get(), host);
+  open_sockets(*s.get(), hosts);
 
   s->all = &all;
   s->delay_ring = calloc_or_throw<example*>(all.p->ring_size);
+  s->delay_ring_connection = calloc_or_throw<size_t>(all.p->ring_size);
+  s->window = window > 0 ? window : std::max<size_t>(1, (all.p->ring_size / 2) / hosts.size());
+  s->batch_size = std::max<size_t>(1, batch_size);
 
   VW::LEARNER::learner<sender, example>& l = init_learner(s, learn, learn, 1);
   l.set_finish_example(finish_example);
@@ -13,6 +13,8 @@
 #include "scope_exit.h"
 
 #include <iterator>
+#include <algorithm>
+#include <vector>
 
 namespace VW
 {
@@ -31,17 +33,87 @@ bool use_reduction(config::options_i& options)
   return false;
 }
 
+// One shared namespace merged into one action example.
+struct sfm_merged_namespace
+{
+  example* ec;
+  namespace_index ns;
+  // Set if the action's feature group refers to the shared features instead of holding a copy. The action's own
+  // (empty) arrays are kept here until they are restored.
+  bool is_view;
+  v_array<feature_value> own_values;
+  v_array<feature_index> own_indicies;
+};
+
 struct sfm_data
 {
+  // A reduction below adds features to the examples (lrq, interact, ...), so every namespace is copied.
+  bool copy_all;
 };
 
+// Namespaces that the multiline reductions below this one write features into. They must own their storage.
+inline bool is_written_below(namespace_index ns)
+{
+  return ns == wap_ldf_namespace || ns == message_namespace || ns == static_cast<unsigned char>('l');
+}
+
+// Makes the shared features visible in the action example. If the action has no features of its own in that
+// namespace, its feature group is pointed at the shared example's arrays, so no features are copied. Otherwise
+// (or with audit strings, or when reductions below write features) the shared features are appended as before.
+void merge_namespace(const sfm_data& data, std::vector<sfm_merged_namespace>& merged_namespaces, example& action,
+    namespace_index ns, features& shared_fs)
+{
+  features& fs = action.feature_space[ns];
+  sfm_merged_namespace merged{&action, ns, false, fs.values, fs.indicies};
+  if (data.copy_all || fs.size() != 0 || !fs.space_names.empty() || !shared_fs.space_names.empty() ||
+      is_written_below(ns))
+  {
+    LabelDict::add_example_namespace(action, ns, shared_fs);
+    merged_namespaces.push_back(merged);
+    return;
+  }
+
+  merged.is_view = true;
+  if (std::find(action.indices.begin(), action.indices.end(), ns) == action.indices.end())
+    action.indices.push_back(ns);
+  fs.values = shared_fs.values;
+  fs.indicies = shared_fs.indicies;
+  fs.sum_feat_sq = shared_fs.sum_feat_sq;
+  action.total_sum_feat_sq += shared_fs.sum_feat_sq;
+  action.num_features += shared_fs.size();
+  merged_namespaces.push_back(merged);
+}
+
+void unmerge_namespace(sfm_merged_namespace& merged, features& shared_fs)
+{
+  example& action = *merged.ec;
+  if (!merged.is_view)
+  {
+    LabelDict::del_example_namespace(action, merged.ns, shared_fs);
+    return;
+  }
+
+  features& fs = action.feature_space[merged.ns];
+  // the view must not have been grown, its storage belongs to the shared example
+  assert(fs.values.begin() == shared_fs.values.begin() && fs.size() == shared_fs.size());
+  if (action.indices.last() == merged.ns)
+    action.indices.pop();
+  fs.values = merged.own_values;
+  fs.indicies = merged.own_indicies;
+  fs.sum_feat_sq = 0.f;
+  action.total_sum_feat_sq -= shared_fs.sum_feat_sq;
+  action.num_features -= shared_fs.size();
+}
+
 template <bool is_learn>
-void predict_or_learn(sfm_data&, VW::LEARNER::multi_learner& base, multi_ex& ec_seq)
+void predict_or_learn(sfm_data& data, VW::LEARNER::multi_learner& base, multi_ex& ec_seq)
 {
   if (ec_seq.size() == 0)
     THROW("cb_adf: At least one action must be provided for an example to be valid.");
 
   multi_ex::value_type shared_example = nullptr;
+  // per thread rather than in data, so that --search_rollout_threads can predict without a lock
+  static thread_local std::vector<sfm_merged_namespace> merged_namespaces;
 
   const bool has_example_header = CB::ec_is_example_header(*ec_seq[0]);
   if (has_example_header)
@@ -49,7 +121,11 @@ void predict_or_learn(sfm_data&, VW::LEARNER::multi_learner& base, multi_ex& ec_
     shared_example = ec_seq[0];
     ec_seq.erase(ec_seq.begin());
     // merge sequences
-    for (auto& example : ec_seq) LabelDict::add_example_namespaces_from_example(*example, *shared_example);
+    merged_namespaces.clear();
+    for (auto& example : ec_seq)
+      for (namespace_index ns : shared_example->indices)
+        if (ns != constant_namespace)
+          merge_namespace(data, merged_namespaces, *example, ns, shared_example->feature_space[ns]);
     std::swap(ec_seq[0]->pred, shared_example->pred);
     std::swap(ec_seq[0]->tag, shared_example->tag);
   }
@@ -60,7 +136,9 @@ void predict_or_learn(sfm_data&, VW::LEARNER::multi_learner& base, multi_ex& ec_
     {
       if (has_example_header)
       {
-        for (auto& example : ec_seq) LabelDict::del_example_namespaces_from_example(*example, *shared_example);
+        for (auto merged = merged_namespaces.rbegin(); merged != merged_namespaces.rend(); ++merged)
+          unmerge_namespace(*merged, shared_example->feature_space[merged->ns]);
+        merged_namespaces.clear();
         std::swap(shared_example->pred, ec_seq[0]->pred);
         std::swap(shared_example->tag, ec_seq[0]->tag);
         ec_seq.insert(ec_seq.begin(), shared_example);
@@ -83,6 +161,7 @@ VW::LEARNER::base_learner* shared_feature_merger_setup(config::options_i& option
   auto data = scoped_calloc_or_throw<sfm_data>();
 
   auto* base = VW::LEARNER::as_multiline(setup_base(options, all));
+  data->copy_all = base->writes_features;
   auto& learner = VW::LEARNER::init_learner(data, base, predict_or_learn<true>, predict_or_learn<false>);
 
   // TODO: Incorrect feature numbers will be reported without merging the example namespaces from the
@@ -40,7 +40,23 @@ void slates_data::learn_or_predict(VW::LEARNER::multi_learner& base, multi_ex& e
   bool global_cost_found = false;
   uint32_t action_index = 0;
   size_t slot_index = 0;
-  std::vector<std::vector<uint32_t>> slot_action_pools(num_slots);
+  // Reuse the pools across calls, only their contents change.
+  if (_slot_action_pools.size() < num_slots)
+  {
+    _slot_action_pools.resize(num_slots);
+  }
+  if (_slot_outcomes.size() < num_slots)
+  {
+    _slot_included_actions.resize(num_slots);
+    _slot_outcomes.resize(num_slots);
+  }
+  for (size_t i = 0; i < num_slots; i++)
+  {
+    _slot_action_pools[i].clear();
+    _slot_included_actions[i].clear();
+    _slot_outcomes[i].probabilities.clear();
+  }
+  auto& slot_action_pools = _slot_action_pools;
   for (size_t i = 0; i < examples.size(); i++)
   {
     CCB::label ccb_label;
@@ -69,17 +85,19 @@ void slates_data::learn_or_predict(VW::LEARNER::multi_learner& base, multi_ex& e
     else if (slates_label.type == slates::example_type::slot)
     {
       ccb_label.type = CCB::example_type::slot;
-      ccb_label.explicit_included_actions = v_init<uint32_t>();
-      for (const auto index : slot_action_pools[slot_index])
+      // The pool is in increasing action order, which lets CCB visit it directly.
+      auto& included_actions = _slot_included_actions[slot_index];
+      const auto& pool = slot_action_pools[slot_index];
+      if (!pool.empty())
       {
-        ccb_label.explicit_included_actions.push_back(index);
+        push_many(included_actions, pool.data(), pool.size());
       }
+      ccb_label.explicit_included_actions = included_actions;
 
       if (global_cost_found)
       {
-        ccb_label.outcome = new CCB::conditional_contextual_bandit_outcome();
+        ccb_label.outcome = &_slot_outcomes[slot_index];
         ccb_label.outcome->cost = global_cost;
-        ccb_label.outcome->probabilities = v_init<ACTION_SCORE::action_score>();
 
         for (const auto& action_score : slates_label.probabilities)
         {
@@ -110,14 +128,20 @@ void slates_data::learn_or_predict(VW::LEARNER::multi_learner& base, multi_ex& e
     size_so_far += static_cast<uint32_t>(action_scores.size());
   }
 
+  // The CCB labels only refer to the pooled storage above, so there is nothing to free.
   for (size_t i = 0; i < examples.size(); i++)
   {
-    CCB::ccb_label_parser.delete_label(&examples[i]->l.conditional_contextual_bandit);
     examples[i]->l.slates = std::move(_stashed_labels[i]);
   }
   _stashed_labels.clear();
 }
 
+slates_data::~slates_data()
+{
+  for (auto& included_actions : _slot_included_actions) included_actions.delete_v();
+  for (auto& outcome : _slot_outcomes) outcome.probabilities.delete_v();
+}
+
 void slates_data::learn(VW::LEARNER::multi_learner& base, multi_ex& examples)
 {
   learn_or_predict<true>(base, examples);
@@ -7,6 +7,7 @@
 #include "reductions_fwd.h"
 
 #include "slates_label.h"
+#include "ccb_label.h"
 #include "learner.h"
 
 #include <string>
@@ -20,6 +21,11 @@ struct slates_data
 {
  private:
   std::vector<label> _stashed_labels;
+  std::vector<std::vector<uint32_t>> _slot_action_pools;
+  // Storage for the CCB labels handed to the slots, kept between calls so that no label memory is allocated per
+  // decision once the pools have grown to the largest slate.
+  std::vector<v_array<uint32_t>> _slot_included_actions;
+  std::vector<CCB::conditional_contextual_bandit_outcome> _slot_outcomes;
 
   /*
   The primary job of this reduction is to convert slate labels to a form CCB can process.
@@ -48,6 +54,7 @@ struct slates_data
   void learn_or_predict(VW::LEARNER::multi_learner& base, multi_ex& examples);
 
  public:
+  ~slates_data();
   void learn(VW::LEARNER::multi_learner& base, multi_ex& examples);
   void predict(VW::LEARNER::multi_learner& base, multi_ex& examples);
 };
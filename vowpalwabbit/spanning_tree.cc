@@ -15,6 +15,15 @@
 #include <cmath>
 #include <map>
 #include <future>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
 
 struct client
 {
@@ -22,12 +31,6 @@ struct client
   socket_t socket;
 };
 
-struct partial
-{
-  client* nodes;
-  size_t filled;
-};
-
 static int socket_sort(const void* s1, const void* s2)
 {
   client* socket1 = (client*)s1;
@@ -71,10 +74,115 @@ int build_tree(int* parent, uint16_t* kid_count, size_t source_count, int offset
 
 void fail_send(const socket_t fd, const void* buf, const int count)
 {
-  if (send(fd, (char*)buf, count, 0) == -1)
+#ifdef MSG_NOSIGNAL
+  // a node that went away must not take the whole coordinator down with SIGPIPE
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+  if (send(fd, (char*)buf, count, flags) == -1)
     THROWERRNO("send: ");
 }
 
+using span_clock = std::chrono::steady_clock;
+
+// Every node sends its job id (nonce), the job's node count and its own node id.
+constexpr size_t span_header_size = 3 * sizeof(size_t);
+
+enum class span_state
+{
+  reading_header,   // waiting for nonce, total and node id
+  waiting_for_job,  // registered, waiting for the remaining nodes of the job
+  reading_port,     // kid count sent, waiting for the port the node listens on for its children
+  done              // port received, waiting for the remaining ports of the job
+};
+
+struct span_connection
+{
+  socket_t socket;
+  uint32_t client_ip;
+  std::string peer;  // for log messages
+  span_state state;
+  char buffer[span_header_size];
+  size_t received;
+  size_t nonce;
+  size_t id;
+  size_t position;  // position of the node in the tree order
+};
+
+struct span_job
+{
+  size_t total;
+  size_t filled;
+  size_t ports_received;
+  std::vector<span_connection*> nodes;  // indexed by node id
+  std::vector<client> order;            // tree order, set once every node has registered
+  std::vector<int> parent;
+  std::vector<uint16_t> ports;
+  span_clock::time_point first_registration;
+  span_clock::time_point topology_sent;
+};
+
+static double elapsed_ms(span_clock::time_point from, span_clock::time_point to)
+{
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Reads whatever is available towards the first target bytes of the connection buffer.
+// Returns false if the peer closed the connection or the read failed.
+static bool read_available(span_connection& c, size_t target)
+{
+  int read_size = recv(c.socket, c.buffer + c.received, (int)(target - c.received), 0);
+  if (read_size <= 0)
+    return false;
+  c.received += read_size;
+  return true;
+}
+
+static void send_topology(span_job& job)
+{
+  // Order the nodes by ip so that nodes sharing a host end up next to each other in the tree.
+  for (span_connection* c : job.nodes) job.order.push_back({c->client_ip, c->socket});
+  qsort(job.order.data(), job.total, sizeof(client), socket_sort);
+
+  std::vector<uint16_t> kid_count(job.total);
+  job.parent.resize(job.total);
+  job.ports.resize(job.total);
+  int root = build_tree(job.parent.data(), kid_count.data(), job.total, 0);
+  job.parent[root] = -1;
+
+  std::unordered_map<socket_t, size_t> position;
+  for (size_t i = 0; i < job.total; i++) position[job.order[i].socket] = i;
+  for (span_connection* c : job.nodes)
+  {
+    c->position = position[c->socket];
+    c->state = span_state::reading_port;
+    c->received = 0;
+    fail_send(c->socket, &kid_count[c->position], sizeof(kid_count[c->position]));
+  }
+  job.topology_sent = span_clock::now();
+}
+
+static void send_parents(span_job& job)
+{
+  for (size_t i = 0; i < job.total; i++)
+  {
+    socket_t socket = job.order[i].socket;
+    if (job.parent[i] >= 0)
+    {
+      fail_send(socket, &job.order[job.parent[i]].client_ip, sizeof(job.order[job.parent[i]].client_ip));
+      fail_send(socket, &job.ports[job.parent[i]], sizeof(job.ports[job.parent[i]]));
+    }
+    else
+    {
+      int bogus = -1;
+      uint32_t bogus2 = -1;
+      fail_send(socket, &bogus2, sizeof(bogus2));
+      fail_send(socket, &bogus, sizeof(bogus));
+    }
+  }
+}
+
 namespace VW
 {
 SpanningTree::SpanningTree(uint16_t port, bool quiet) : m_stop(false), m_port(port), m_future(nullptr), m_quiet(quiet)
@@ -153,167 +261,259 @@ void SpanningTree::Stop()
 
 void SpanningTree::Run()
 {
-  std::map<size_t, partial> partial_nodesets;
-  while (!m_stop)
-  {
-    if (listen(sock, 1024) < 0)
-      THROWERRNO("listen: ");
-
-    sockaddr_in client_address;
-    socklen_t size = sizeof(client_address);
-    socket_t f = accept(sock, (sockaddr*)&client_address, &size);
-#ifdef _WIN32
-    if (f == INVALID_SOCKET)
-    {
-#else
-    if (f < 0)
-    {
-#endif
-      break;
-    }
+  if (listen(sock, SOMAXCONN) < 0)
+    THROWERRNO("listen: ");
 
-    char dotted_quad[INET_ADDRSTRLEN];
-    if (NULL == inet_ntop(AF_INET, &(client_address.sin_addr), dotted_quad, INET_ADDRSTRLEN))
-      THROWERRNO("inet_ntop: ");
+  // Connections are serviced as their data arrives, so a slow node only delays its own job.
+  std::unordered_map<socket_t, span_connection> connections;
+  std::map<size_t, span_job> jobs;
+  std::vector<pollfd> fds;
 
-    char hostname[NI_MAXHOST];
-    char servInfo[NI_MAXSERV];
-    if (getnameinfo((sockaddr*)&client_address, sizeof(sockaddr), hostname, NI_MAXHOST, servInfo, NI_MAXSERV, 0))
-      THROWERRNO("getnameinfo: ");
+  auto close_connection = [&](span_connection& c) {
+    CLOSESOCK(c.socket);
+    connections.erase(c.socket);
+  };
 
+  auto abort_job = [&](size_t nonce, const std::string& reason) {
+    span_job& job = jobs[nonce];
+    if (!m_quiet)
+      std::cerr << "nonce " << nonce << ": " << reason << ", dropping the job's " << job.filled << " nodes"
+                << std::endl;
+    for (span_connection* c : job.nodes)
+      if (c != nullptr)
+        close_connection(*c);
+    jobs.erase(nonce);
+  };
+
+  auto register_node = [&](span_connection& c) {
+    size_t total;
+    memcpy(&c.nonce, c.buffer, sizeof(size_t));
+    memcpy(&total, c.buffer + sizeof(size_t), sizeof(size_t));
+    memcpy(&c.id, c.buffer + 2 * sizeof(size_t), sizeof(size_t));
     if (!m_quiet)
-      std::cerr << "inbound connection from " << dotted_quad << "(" << hostname << ':' << ntohs(m_port)
-                << ") serv=" << servInfo << std::endl;
+      std::cerr << c.peer << ": nonce=" << c.nonce << " total=" << total << " node id=" << c.id << std::endl;
 
-    size_t nonce = 0;
-    if (recv(f, (char*)&nonce, sizeof(nonce), 0) != sizeof(nonce))
+    int ok = true;
+    if (c.id >= total)
     {
-      THROW(dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): nonce read failed, exiting");
+      if (!m_quiet)
+        std::cout << c.peer << ": invalid id=" << c.id << " >=  " << total << " !" << std::endl;
+      ok = false;
     }
-    else
+
+    auto found = jobs.find(c.nonce);
+    if (ok && found == jobs.end())
     {
-      if (!m_quiet)
-        std::cerr << dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): nonce=" << nonce << std::endl;
+      span_job& job = jobs[c.nonce];
+      job.total = total;
+      job.filled = 0;
+      job.ports_received = 0;
+      job.nodes.assign(total, nullptr);
+      job.first_registration = span_clock::now();
+      found = jobs.find(c.nonce);
     }
-    size_t total = 0;
-    if (recv(f, (char*)&total, sizeof(total), 0) != sizeof(total))
+    if (ok && (found->second.total != total || found->second.nodes[c.id] != nullptr ||
+                  found->second.filled == found->second.total))
+      ok = false;
+    try
     {
-      THROW(dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): total node count read failed, exiting");
+      fail_send(c.socket, &ok, sizeof(ok));
     }
-    else
+    catch (VW::vw_exception& e)
     {
+      // As for a node that disconnects while waiting, only its slot is lost and the rest of the job keeps waiting.
       if (!m_quiet)
-        std::cerr << dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): total=" << total << std::endl;
+        std::cerr << c.peer << ": acknowledging the registration failed: " << e.what() << std::endl;
+      size_t nonce = c.nonce;
+      close_connection(c);
+      if (ok && found->second.filled == 0)
+        jobs.erase(nonce);
+      return;
     }
-    size_t id = 0;
-    if (recv(f, (char*)&id, sizeof(id), 0) != sizeof(id))
+    if (!ok)
     {
-      THROW(dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): node id read failed, exiting");
+      close_connection(c);
+      return;
     }
-    else
+
+    span_job& job = found->second;
+    job.nodes[c.id] = &c;
+    job.filled++;
+    c.state = span_state::waiting_for_job;
+    if (job.filled != job.total)
     {
       if (!m_quiet)
-        std::cerr << dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): node id=" << id << std::endl;
+        for (size_t i = 0; i < job.total; i++)
+          if (job.nodes[i] == nullptr)
+          {
+            std::cout << "nonce " << c.nonce << " still waiting for " << (job.total - job.filled) << " nodes out of "
+                      << job.total << " for example node " << i << std::endl;
+            break;
+          }
+      return;
     }
 
-    int ok = true;
-    if (id >= total)
+    try
     {
-      if (!m_quiet)
-        std::cout << dotted_quad << "(" << hostname << ':' << ntohs(m_port) << "): invalid id=" << id
-                  << " >=  " << total << " !" << std::endl;
-      ok = false;
+      send_topology(job);
     }
-    partial partial_nodeset;
-
-    if (partial_nodesets.find(nonce) == partial_nodesets.end())
+    catch (VW::vw_exception& e)
     {
-      partial_nodeset.nodes = (client*)calloc(total, sizeof(client));
-      for (size_t i = 0; i < total; i++) partial_nodeset.nodes[i].client_ip = (uint32_t)-1;
-      partial_nodeset.filled = 0;
+      abort_job(c.nonce, std::string("sending topology failed: ") + e.what());
     }
-    else
+  };
+
+  auto read_port = [&](span_connection& c) {
+    span_job& job = jobs[c.nonce];
+    memcpy(&job.ports[c.position], c.buffer, sizeof(uint16_t));
+    c.state = span_state::done;
+    if (++job.ports_received != job.total)
+      return;
+
+    // all clients have bound to their ports.
+    size_t nonce = c.nonce;
+    try
     {
-      partial_nodeset = partial_nodesets[nonce];
-      partial_nodesets.erase(nonce);
+      send_parents(job);
     }
-
-    if (ok && partial_nodeset.nodes[id].client_ip != (uint32_t)-1)
-      ok = false;
-    fail_send(f, &ok, sizeof(ok));
-
-    if (ok)
+    catch (VW::vw_exception& e)
     {
-      partial_nodeset.nodes[id].client_ip = client_address.sin_addr.s_addr;
-      partial_nodeset.nodes[id].socket = f;
-      partial_nodeset.filled++;
+      abort_job(nonce, std::string("sending parents failed: ") + e.what());
+      return;
     }
-    if (partial_nodeset.filled != total)  // Need to wait for more connections
+    if (!m_quiet)
     {
-      partial_nodesets[nonce] = partial_nodeset;
-      for (size_t i = 0; i < total; i++)
-      {
-        if (partial_nodeset.nodes[i].client_ip == (uint32_t)-1)
+      auto now = span_clock::now();
+      std::cerr << "nonce " << nonce << ": " << job.total << " nodes registered in "
+                << elapsed_ms(job.first_registration, job.topology_sent) << " ms, ports collected in "
+                << elapsed_ms(job.topology_sent, now) << " ms" << std::endl;
+    }
+    for (span_connection* n : job.nodes) close_connection(*n);
+    jobs.erase(nonce);
+  };
+
+  auto service = [&](span_connection& c) {
+    switch (c.state)
+    {
+      case span_state::reading_header:
+        if (!read_available(c, span_header_size))
         {
           if (!m_quiet)
-            std::cout << "nonce " << nonce << " still waiting for " << (total - partial_nodeset.filled)
-                      << " nodes out of " << total << " for example node " << i << std::endl;
-          break;
+            std::cerr << c.peer << ": registration read failed" << std::endl;
+          close_connection(c);
         }
+        else if (c.received == span_header_size)
+          register_node(c);
+        break;
+
+      case span_state::waiting_for_job:
+      {
+        // Nodes do not send anything while waiting, so readability means they went away.
+        span_job& job = jobs[c.nonce];
+        if (!m_quiet)
+          std::cerr << c.peer << ": node id=" << c.id << " disconnected before nonce " << c.nonce << " was complete"
+                    << std::endl;
+        job.nodes[c.id] = nullptr;
+        size_t nonce = c.nonce;
+        close_connection(c);
+        if (--job.filled == 0)
+          jobs.erase(nonce);
+        break;
       }
+
+      case span_state::reading_port:
+        if (!read_available(c, sizeof(uint16_t)))
+          abort_job(c.nonce, c.peer + ": port read failed");
+        else if (c.received == sizeof(uint16_t))
+          read_port(c);
+        break;
+
+      case span_state::done:
+        abort_job(c.nonce, c.peer + ": unexpected data or disconnect");
+        break;
     }
-    else
-    {
-      // Time to make the spanning tree
-      qsort(partial_nodeset.nodes, total, sizeof(client), socket_sort);
+  };
 
-      int* parent = (int*)calloc(total, sizeof(int));
-      uint16_t* kid_count = (uint16_t*)calloc(total, sizeof(uint16_t));
+  while (!m_stop)
+  {
+    fds.clear();
+    fds.push_back({sock, POLLIN, 0});
+    for (auto& c : connections) fds.push_back({c.first, POLLIN, 0});
+
+    // Wake up periodically so that Stop() is noticed even without traffic.
+    int ready = poll(fds.data(), (unsigned long)fds.size(), 100);
+    if (ready < 0)
+    {
+#ifndef _WIN32
+      if (errno == EINTR)
+        continue;
+#endif
+      if (!m_stop)
+        std::cerr << "spanning tree: poll failed: " << strerror(errno) << std::endl;
+      break;
+    }
+    if (fds[0].revents & (POLLERR | POLLNVAL))
+    {
+      if (!m_stop)
+        std::cerr << "spanning tree: listening socket failed" << std::endl;
+      break;
+    }
 
-      int root = build_tree(parent, kid_count, total, 0);
-      parent[root] = -1;
+    for (size_t i = 1; i < fds.size(); i++)
+    {
+      if (fds[i].revents == 0)
+        continue;
+      // earlier events in this round may already have closed the connection
+      auto found = connections.find(fds[i].fd);
+      if (found != connections.end())
+        service(found->second);
+    }
 
-      for (size_t i = 0; i < total; i++)
+    if (fds[0].revents & POLLIN)
+    {
+      sockaddr_in client_address;
+      socklen_t size = sizeof(client_address);
+      socket_t f = accept(sock, (sockaddr*)&client_address, &size);
+#ifdef _WIN32
+      if (f == INVALID_SOCKET)
       {
-        fail_send(partial_nodeset.nodes[i].socket, &kid_count[i], sizeof(kid_count[i]));
+        int error = WSAGetLastError();
+        // a client that gave up before it was accepted, or an interrupted call, does not stop the others
+        if (error == WSAEINTR || error == WSAECONNRESET)
+          continue;
+        if (!m_stop)
+          std::cerr << "spanning tree: accept failed with error " << error << std::endl;
+        break;
       }
-
-      uint16_t* client_ports = (uint16_t*)calloc(total, sizeof(uint16_t));
-
-      for (size_t i = 0; i < total; i++)
+#else
+      if (f < 0)
       {
-        int done = 0;
-        if (recv(partial_nodeset.nodes[i].socket, (char*)&(client_ports[i]), sizeof(client_ports[i]), 0) <
-            (int)sizeof(client_ports[i]))
+        // a client that gave up before it was accepted, or an interrupted call, does not stop the others
+        if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO)
+          continue;
+        if (!m_stop)
+          std::cerr << "spanning tree: accept failed: " << strerror(errno) << std::endl;
+        break;
+      }
+#endif
 
-          if (!m_quiet)
-            std::cerr << " Port read failed for node " << i << " read " << done << std::endl;
-      }  // all clients have bound to their ports.
+      char dotted_quad[INET_ADDRSTRLEN];
+      if (NULL == inet_ntop(AF_INET, &(client_address.sin_addr), dotted_quad, INET_ADDRSTRLEN))
+        THROWERRNO("inet_ntop: ");
 
-      for (size_t i = 0; i < total; i++)
-      {
-        if (parent[i] >= 0)
-        {
-          fail_send(partial_nodeset.nodes[i].socket, &partial_nodeset.nodes[parent[i]].client_ip,
-              sizeof(partial_nodeset.nodes[parent[i]].client_ip));
-          fail_send(partial_nodeset.nodes[i].socket, &client_ports[parent[i]], sizeof(client_ports[parent[i]]));
-        }
-        else
-        {
-          int bogus = -1;
-          uint32_t bogus2 = -1;
-          fail_send(partial_nodeset.nodes[i].socket, &bogus2, sizeof(bogus2));
-          fail_send(partial_nodeset.nodes[i].socket, &bogus, sizeof(bogus));
-        }
-        CLOSESOCK(partial_nodeset.nodes[i].socket);
-      }
-      free(client_ports);
-      free(partial_nodeset.nodes);
-      free(parent);
-      free(kid_count);
+      span_connection& c = connections[f];
+      c.socket = f;
+      c.client_ip = client_address.sin_addr.s_addr;
+      c.state = span_state::reading_header;
+      c.received = 0;
+      c.peer = std::string(dotted_quad) + ":" + std::to_string(ntohs(client_address.sin_port));
+      if (!m_quiet)
+        std::cerr << "inbound connection from " << c.peer << std::endl;
     }
   }
 
+  for (auto& c : connections) CLOSESOCK(c.first);
+
 #ifdef _WIN32
   WSACleanup();
 #endif
@@ -0,0 +1,105 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+// Dot product of two sparse vectors stored as sorted index and value arrays, as produced by flatten_sort_example.
+// Define VW_NO_INLINE_SIMD to always use the scalar merge.
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(VW_NO_INLINE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VW_SPARSE_DOT_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace VW
+{
+namespace details
+{
+// Merges idx1[i, end1) against idx2[j, n2) and accumulates the products of equal indices into dotprod.
+// Repeated indices are paired in order, the k-th occurrence on one side with the k-th on the other.
+inline void sparse_dot_merge(const uint64_t* idx1, const float* val1, size_t& i, size_t end1, const uint64_t* idx2,
+    const float* val2, size_t& j, size_t n2, float& dotprod)
+{
+  for (; i < end1 && j < n2; i++)
+  {
+    uint64_t pos1 = idx1[i];
+    uint64_t pos2 = idx2[j];
+    if (pos1 < pos2)
+      continue;
+
+    while (pos1 > pos2 && ++j < n2) pos2 = idx2[j];
+
+    if (pos1 == pos2)
+    {
+      dotprod += val1[i] * val2[j];
+      ++j;
+    }
+  }
+}
+
+#ifdef VW_SPARSE_DOT_SIMD
+// Low and high 32 bit halves of four consecutive 64 bit indices.
+inline void load_index_halves(const uint64_t* idx, __m128i& lo, __m128i& hi)
+{
+  const __m128 first = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(idx)));
+  const __m128 second = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(idx + 2)));
+  lo = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+  hi = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// True if any of the four indices at idx1 equals any of the four at idx2.
+inline bool blocks_intersect(const uint64_t* idx1, const uint64_t* idx2)
+{
+  __m128i lo1, hi1, lo2, hi2;
+  load_index_halves(idx1, lo1, hi1);
+  load_index_halves(idx2, lo2, hi2);
+
+  __m128i any = _mm_and_si128(_mm_cmpeq_epi32(lo1, lo2), _mm_cmpeq_epi32(hi1, hi2));
+  lo2 = _mm_shuffle_epi32(lo2, _MM_SHUFFLE(0, 3, 2, 1));
+  hi2 = _mm_shuffle_epi32(hi2, _MM_SHUFFLE(0, 3, 2, 1));
+  any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(lo1, lo2), _mm_cmpeq_epi32(hi1, hi2)));
+  lo2 = _mm_shuffle_epi32(lo2, _MM_SHUFFLE(0, 3, 2, 1));
+  hi2 = _mm_shuffle_epi32(hi2, _MM_SHUFFLE(0, 3, 2, 1));
+  any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(lo1, lo2), _mm_cmpeq_epi32(hi1, hi2)));
+  lo2 = _mm_shuffle_epi32(lo2, _MM_SHUFFLE(0, 3, 2, 1));
+  hi2 = _mm_shuffle_epi32(hi2, _MM_SHUFFLE(0, 3, 2, 1));
+  any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(lo1, lo2), _mm_cmpeq_epi32(hi1, hi2)));
+  return _mm_movemask_epi8(any) != 0;
+}
+#endif
+}  // namespace details
+
+// Sum of val1[i] * val2[j] over idx1[i] == idx2[j], for index arrays sorted in increasing order.
+// Blocks of four indices without a common entry are skipped with SIMD compares. Blocks that do intersect go through
+// the scalar merge, so products are added in the same order and the result is bit identical to a plain merge join.
+inline float sparse_dot(
+    const uint64_t* idx1, const float* val1, size_t n1, const uint64_t* idx2, const float* val2, size_t n2)
+{
+  float dotprod = 0.f;
+  size_t i = 0;
+  size_t j = 0;
+#ifdef VW_SPARSE_DOT_SIMD
+  while (i + 4 <= n1 && j + 4 <= n2)
+  {
+    if (details::blocks_intersect(idx1 + i, idx2 + j))
+    {
+      details::sparse_dot_merge(idx1, val1, i, i + 4, idx2, val2, j, n2, dotprod);
+      continue;
+    }
+    const uint64_t max1 = idx1[i + 3];
+    const uint64_t max2 = idx2[j + 3];
+    if (max1 <= max2)
+      i += 4;
+    if (max2 <= max1)
+      j += 4;
+  }
+#endif
+  details::sparse_dot_merge(idx1, val1, i, n1, idx2, val2, j, n2, dotprod);
+  return dotprod;
+}
+}  // namespace VW
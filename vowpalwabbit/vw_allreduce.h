@@ -7,17 +7,31 @@
 #include "vw.h"
 #include "allreduce.h"
 
+// Runs the reduction on the configured backend without waiting for background reductions.
+// Only the thread that owns the background reduction should call this directly.
 template <class T, void (*f)(T&, const T&)>
-void all_reduce(vw& all, T* buffer, const size_t n)
+void all_reduce_unsynchronized(AllReduceType type, AllReduce* reducer, T* buffer, const size_t n)
 {
-  switch (all.all_reduce_type)
+  switch (type)
   {
     case AllReduceType::Socket:
-      ((AllReduceSockets*)all.all_reduce)->all_reduce<T, f>(buffer, n);
+      ((AllReduceSockets*)reducer)->all_reduce<T, f>(buffer, n);
       break;
 
     case AllReduceType::Thread:
-      ((AllReduceThreads*)all.all_reduce)->all_reduce<T, f>(buffer, n);
+      ((AllReduceThreads*)reducer)->all_reduce<T, f>(buffer, n);
+      break;
+
+    case AllReduceType::SharedMemory:
+      ((AllReduceSharedMemory*)reducer)->all_reduce<T, f>(buffer, n);
       break;
   }
 }
+
+template <class T, void (*f)(T&, const T&)>
+void all_reduce(vw& all, T* buffer, const size_t n)
+{
+  if (all.all_reduce->join_background)
+    all.all_reduce->join_background();
+  all_reduce_unsynchronized<T, f>(all.all_reduce_type, all.all_reduce, buffer, n);
+}
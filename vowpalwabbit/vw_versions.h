@@ -16,3 +16,4 @@
   "8.0.2"  // first version with header's chained hash used for more reliably validating model content
 #define VERSION_FILE_WITH_HEADER_ID "8.0.3"    // first version with user supplied header
 #define VERSION_FILE_WITH_CB_ADF_SAVE "8.3.2"  // first version with user supplied header
+#define VERSION_FILE_WITH_LDA_TOTAL_LAMBDA "8.8.2"  // first version that saves the per topic weight sums of lda